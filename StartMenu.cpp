@@ -77,7 +77,7 @@ void StartMenu::onLoadGameClicked()
 {
     QString fileName = QFileDialog::getOpenFileName(this, "载入游戏", "", "游戏存档 (*.sav)");
     if (!fileName.isEmpty()) {
-        GameBoard *gameBoard = new GameBoard(nullptr, false);  // 假设载入的游戏是单人模式
+        GameBoard *gameBoard = new GameBoard(nullptr, false, true);  // 模式由存档决定
         gameBoard->loadGame(fileName);
         gameBoard->show();
         this->close();
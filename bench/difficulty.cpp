@@ -0,0 +1,78 @@
+// 按难度生成地图：模拟对局评分在不同线程数下的耗时，以及每种难度生成一张地图的耗时
+// 用法：difficulty [每种难度的地图数]
+#include "board.h"
+#include "difficulty.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int RATE_REPEATS = 20;
+
+}
+
+int main(int argc, char *argv[])
+{
+    int boardCount = argc > 1 ? std::atoi(argv[1]) : 20;
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    std::printf("%dx%d boards, %d playouts per rating, %d hardware threads\n",
+                Board::GRID_SIZE, Board::GRID_SIZE, Board::RATING_PLAYOUTS, cores);
+
+    // 同一张地图反复评分，结果与线程数无关，只比较耗时
+    Board sample;
+    sample.seed(1);
+    sample.generateMap();
+    std::printf("%8s %14s %10s %9s\n", "threads", "rate(ms)", "score", "speedup");
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < cores; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(std::max(cores, 1));
+    double baseline = 0;
+    for (int threads : threadCounts) {
+        DifficultyRater rater;
+        DifficultyRater::Limits limits;
+        limits.playouts = Board::RATING_PLAYOUTS;
+        limits.threads = threads;
+        double score = 0;
+        auto start = Clock::now();
+        for (int i = 0; i < RATE_REPEATS; ++i) {
+            score = rater.rate(sample, limits).score;
+        }
+        std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+        double perRating = elapsed.count() / RATE_REPEATS;
+        if (threads == 1) {
+            baseline = perRating;
+        }
+        std::printf("%8d %14.2f %10.3f %8.2fx\n", threads, perRating, score, baseline / perRating);
+    }
+
+    // 按难度生成，评分用全部核心
+    const char *names[] = {"easy", "normal", "hard"};
+    std::printf("\n%8s %10s %12s %12s %10s\n", "level", "in band", "avg(ms)", "max(ms)", "blocks");
+    for (int level = 0; level < 3; ++level) {
+        int inBand = 0;
+        long long blocks = 0;
+        double total = 0;
+        double slowest = 0;
+        for (int seed = 0; seed < boardCount; ++seed) {
+            Board board;
+            board.seed(seed);
+            auto start = Clock::now();
+            inBand += board.generateMap(static_cast<Board::Difficulty>(level));
+            std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+            total += elapsed.count();
+            slowest = std::max(slowest, elapsed.count());
+            blocks += board.blockCount();
+        }
+        std::printf("%8s %7d/%-2d %12.1f %12.1f %10.1f\n", names[level], inBand, boardCount,
+                    total / boardCount, slowest, static_cast<double>(blocks) / boardCount);
+    }
+    return 0;
+}
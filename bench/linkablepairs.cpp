@@ -0,0 +1,99 @@
+// 找出整张棋盘上所有可以消除的方块对：逐对查询与一次性批量计算的耗时对比
+// 用法：linkablepairs [重复次数]
+#include "board.h"
+#include "fixedboard.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// 生成地图后随机清掉约三分之一的格子，模拟对局中途的局面
+void prepareBoard(Board &board, int rows, int cols, unsigned int seed)
+{
+    board.seed(seed);
+    board.resize(rows, cols);
+    board.generateMap();
+    std::mt19937 rng(seed);
+    for (int i = 0; i < rows * cols / 3; ++i) {
+        board.setCell(rng() % rows, rng() % cols, Board::EMPTY);
+    }
+}
+
+// 逐对调用 f(row1, col1, row2, col2)，返回能连接的对数
+template <typename F>
+int queryEveryPair(const Board &board, F f)
+{
+    const CellGrid &grid = board.cells();
+    int count = 0;
+    for (int type = 0; type < Board::MAX_BLOCK_TYPES; ++type) {
+        const SparseCellSet &cells = board.blocksOfType(type);
+        for (int i = 0; i < cells.size(); ++i) {
+            for (int j = i + 1; j < cells.size(); ++j) {
+                if (f(grid.rowOf(cells[i]), grid.colOf(cells[i]), grid.rowOf(cells[j]), grid.colOf(cells[j]))) {
+                    ++count;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+template <typename F>
+double timeIt(int repeat, int *result, F f)
+{
+    auto start = Clock::now();
+    for (int i = 0; i < repeat; ++i) {
+        *result = f();
+    }
+    std::chrono::duration<double, std::micro> elapsed = Clock::now() - start;
+    return elapsed.count() / repeat;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    int repeat = argc > 1 ? std::atoi(argv[1]) : 20;
+    const int sizes[] = {Board::GRID_SIZE, 30, Board::MAX_SIZE};
+
+    std::printf("%-8s %8s %14s %14s %14s\n", "size", "pairs", "connect(us)", "kernel(us)", "batch(us)");
+    for (int size : sizes) {
+        Board board;
+        prepareBoard(board, size, size, 2024);
+        // 两个内核只实现两折、不出界的规则，逐对查询用同一规则才能对比
+        Board::LinkRule rule;
+        rule.maxTurns = 2;
+        rule.allowOutside = false;
+        board.setLinkRule(rule);
+
+        int connected = 0, kernel = 0, batch = 0;
+        double connectTime = timeIt(repeat, &connected, [&]() {
+            return queryEveryPair(board, [&](int r1, int c1, int r2, int c2) {
+                return board.connect(r1, c1, r2, c2);
+            });
+        });
+        double kernelTime = timeIt(repeat, &kernel, [&]() {
+            int count = 0;
+            FixedKernels::forEachLinkablePair(board, [&count](int, int) { ++count; });
+            return count;
+        });
+        double batchTime = timeIt(repeat, &batch, [&]() {
+            int count = 0;
+            board.bitBoard().forEachLinkablePair([&count](int, int, int, int) { ++count; });
+            return count;
+        });
+
+        if (connected != kernel || connected != batch) {
+            std::fprintf(stderr, "mismatch at %dx%d: %d %d %d\n", size, size, connected, kernel, batch);
+            return 1;
+        }
+        char name[16];
+        std::snprintf(name, sizeof(name), "%dx%d", size, size);
+        std::printf("%-8s %8d %14.1f %14.1f %14.1f\n", name, batch, connectTime, kernelTime, batchTime);
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+// 整局可解性搜索：不同线程数下的耗时与加速比
+// 用法：solver [棋盘数] [节点预算]
+#include "board.h"
+#include "solver.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int BOARD_SIZE = 12;
+constexpr int BLOCK_TYPES = 6;
+constexpr int SCREEN_SEEDS = 400;
+constexpr long long SCREEN_NODES = 20000;
+constexpr long long HARD_NODES = 2000;
+
+// 四周留空、10% 道具、其余随机成对的方块；种类比 generateMap 多，更容易出现需要回溯的局面
+void prepareBoard(Board &board, unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    int inner = BOARD_SIZE - 2;
+    int cells = inner * inner;
+    std::vector<int> items(cells / 10, Board::PROP);
+    while (static_cast<int>(items.size()) + 2 <= cells) {
+        int type = static_cast<int>(rng() % BLOCK_TYPES);
+        items.push_back(type);
+        items.push_back(type);
+    }
+    items.resize(cells, Board::EMPTY);
+    std::shuffle(items.begin(), items.end(), rng);
+
+    board.resize(BOARD_SIZE, BOARD_SIZE);
+    for (int i = 0; i < cells; ++i) {
+        board.setCell(i / inner + 1, i % inner + 1, items[i]);
+    }
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    int boardCount = argc > 1 ? std::atoi(argv[1]) : 4;
+    long long maxNodes = argc > 2 ? std::atoll(argv[2]) : 200000;
+
+    // 大多数随机局面不用回溯就能解开，先用小预算筛出单线程下要搜索很多节点的局面
+    std::vector<Board> boards;
+    for (int seed = 0; seed < SCREEN_SEEDS && static_cast<int>(boards.size()) < boardCount; ++seed) {
+        Board board;
+        prepareBoard(board, seed);
+        Solver solver;
+        Solver::Limits limits;
+        limits.maxNodes = SCREEN_NODES;
+        solver.solve(board, limits);
+        if (solver.nodeCount() >= HARD_NODES) {
+            boards.push_back(board);
+        }
+    }
+
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    std::printf("%d boards (%dx%d, %d types), node budget %lld, %d hardware threads\n",
+                static_cast<int>(boards.size()), BOARD_SIZE, BOARD_SIZE, BLOCK_TYPES, maxNodes, cores);
+    std::printf("%8s %12s %12s %10s %10s %10s %10s\n", "threads", "time(ms)", "nodes", "solvable", "unsolvable", "unknown", "speedup");
+
+    // 1, 2, 4, ... 直到核心数
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < cores; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(std::max(cores, 1));
+
+    double baseline = 0;
+    for (int threads : threadCounts) {
+        int results[3] = {0, 0, 0};
+        long long nodes = 0;
+        auto start = Clock::now();
+        for (const Board &board : boards) {
+            Solver solver;
+            Solver::Limits limits;
+            limits.maxNodes = maxNodes;
+            limits.threads = threads;
+            ++results[static_cast<int>(solver.solve(board, limits))];
+            nodes += solver.nodeCount();
+        }
+        std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+        if (threads == 1) {
+            baseline = elapsed.count();
+        }
+        std::printf("%8d %12.1f %12lld %10d %10d %10d %9.2fx\n", threads, elapsed.count(), nodes,
+                    results[0], results[1], results[2], baseline / elapsed.count());
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include "boardpool.h"
+#include <QDebug>
+#include <utility>
+
+BoardPool &BoardPool::instance()
+{
+    static BoardPool pool;
+    return pool;
+}
+
+BoardPool::BoardPool(QObject *parent)
+    : QThread(parent), stopping(false)
+{
+}
+
+BoardPool::~BoardPool()
+{
+    stop();
+}
+
+void BoardPool::prepare(bool isTwoPlayerMode, int rows, int cols)
+{
+    QMutexLocker locker(&mutex);
+    pools[Key(isTwoPlayerMode, rows, cols)];
+    wakeWorker();
+}
+
+Board BoardPool::take(bool isTwoPlayerMode, int rows, int cols)
+{
+    Key key(isTwoPlayerMode, rows, cols);
+    {
+        QMutexLocker locker(&mutex);
+        std::deque<Board> &pool = pools[key];
+        wakeWorker();
+        if (!pool.empty()) {
+            Board board = std::move(pool.front());
+            pool.pop_front();
+            return board;
+        }
+    }
+    // 按难度生成要跑求解和评分，不能放在界面线程上；生成普通地图只要几毫秒
+    qDebug() << "Board pool empty, using an unrated map";
+    Board board = blankBoard(key);
+    board.generateMap();
+    return board;
+}
+
+void BoardPool::stop()
+{
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        wanted.wakeAll();
+    }
+    wait();
+}
+
+void BoardPool::wakeWorker()
+{
+    if (stopping) {
+        return;
+    }
+    if (!isRunning()) {
+        start(QThread::IdlePriority);
+    }
+    wanted.wakeOne();
+}
+
+Board BoardPool::blankBoard(const Key &key)
+{
+    Board board(std::get<0>(key));
+    board.resize(std::get<1>(key), std::get<2>(key));
+    return board;
+}
+
+Board BoardPool::generate(const Key &key)
+{
+    Board board = blankBoard(key);
+    // 评分只用这一个线程，不占用前台的核心
+    board.generateMap(Board::Difficulty::Normal, 1);
+    return board;
+}
+
+void BoardPool::run()
+{
+    QMutexLocker locker(&mutex);
+    while (!stopping) {
+        // 一次补一张，补完重新找缺得最多的种类
+        auto missing = pools.end();
+        for (auto it = pools.begin(); it != pools.end(); ++it) {
+            if (static_cast<int>(it->second.size()) < POOL_SIZE &&
+                (missing == pools.end() || it->second.size() < missing->second.size())) {
+                missing = it;
+            }
+        }
+        if (missing == pools.end()) {
+            wanted.wait(&mutex);
+            continue;
+        }
+        Key key = missing->first;
+        locker.unlock();
+        Board board = generate(key);
+        locker.relock();
+        pools[key].push_back(std::move(board));
+    }
+}
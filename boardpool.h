@@ -0,0 +1,44 @@
+#ifndef BOARDPOOL_H
+#define BOARDPOOL_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <deque>
+#include <map>
+#include <tuple>
+#include "board.h"
+
+// 预先生成好的地图：每种（模式, 行数, 列数）各存 POOL_SIZE 张，由一个最低优先级的后台线程补满
+// 开始新游戏时直接取走一张，后台随后补上；池子还没补上时现场生成一张不按难度筛选的地图，不让调用方等待
+class BoardPool : public QThread
+{
+    Q_OBJECT
+
+public:
+    static BoardPool &instance();
+
+    void prepare(bool isTwoPlayerMode, int rows = Board::GRID_SIZE, int cols = Board::GRID_SIZE);  // 登记一种地图，后台开始补满
+    Board take(bool isTwoPlayerMode, int rows = Board::GRID_SIZE, int cols = Board::GRID_SIZE);
+    void stop();  // 等后台线程生成完手上这一张后退出
+
+protected:
+    void run() override;
+
+private:
+    explicit BoardPool(QObject *parent = nullptr);
+    ~BoardPool() override;
+
+    using Key = std::tuple<bool, int, int>;
+    static Board blankBoard(const Key &key);
+    static Board generate(const Key &key);
+    void wakeWorker();  // 调用时要持有 mutex
+
+    static const int POOL_SIZE = 2;  // 每种地图预先存几张
+    QMutex mutex;
+    QWaitCondition wanted;  // 有地图被取走或者登记了新的种类
+    std::map<Key, std::deque<Board>> pools;
+    bool stopping;
+};
+
+#endif // BOARDPOOL_H
@@ -0,0 +1,219 @@
+#include "bitboard.h"
+
+BitBoard::BitBoard()
+    : numRows(0), numCols(0)
+{
+    rowBits.fill(0);
+    colBits.fill(0);
+    for (auto &rows : typeRows) {
+        rows.fill(0);
+    }
+    for (auto &cols : typeCols) {
+        cols.fill(0);
+    }
+}
+
+void BitBoard::reset(const CellGrid &grid)
+{
+    numRows = grid.rows();
+    numCols = grid.cols();
+    rowBits.fill(0);
+    colBits.fill(0);
+    for (auto &rows : typeRows) {
+        rows.fill(0);
+    }
+    for (auto &cols : typeCols) {
+        cols.fill(0);
+    }
+
+    for (int index = 0; index < grid.size(); ++index) {
+        update(grid, index);
+    }
+}
+
+void BitBoard::update(const CellGrid &grid, int index)
+{
+    int row = index / grid.stride();
+    int col = index % grid.stride();
+    uint64_t rowBit = uint64_t(1) << col;
+    uint64_t colBit = uint64_t(1) << row;
+    uint8_t code = grid.code(index);
+
+    if (code == CellGrid::CODE_EMPTY) {
+        rowBits[row] &= ~rowBit;
+        colBits[col] &= ~colBit;
+    } else {
+        rowBits[row] |= rowBit;
+        colBits[col] |= colBit;
+    }
+
+    for (int type = 0; type < MAX_TYPES; ++type) {
+        typeRows[type][row] &= ~rowBit;
+        typeCols[type][col] &= ~colBit;
+    }
+    if (grid.isBlock(index)) {
+        typeRows[code - CellGrid::CODE_BLOCK][row] |= rowBit;
+        typeCols[code - CellGrid::CODE_BLOCK][col] |= colBit;
+    }
+}
+
+int BitBoard::rayLeft(int row, int col) const
+{
+    uint64_t blockers = rowBits[row + 1] & ((uint64_t(1) << (col + 1)) - 1);
+    return highestBit(blockers) - 1;
+}
+
+int BitBoard::rayRight(int row, int col) const
+{
+    uint64_t blockers = rowBits[row + 1] >> (col + 2);
+    return lowestBit(blockers) + col + 1;
+}
+
+int BitBoard::rayUp(int row, int col) const
+{
+    uint64_t blockers = colBits[col + 1] & ((uint64_t(1) << (row + 1)) - 1);
+    return highestBit(blockers) - 1;
+}
+
+int BitBoard::rayDown(int row, int col) const
+{
+    uint64_t blockers = colBits[col + 1] >> (row + 2);
+    return lowestBit(blockers) + row + 1;
+}
+
+bool BitBoard::rowSegmentClear(int row, int col1, int col2) const
+{
+    return (rowBits[row + 1] & bitsBetween(col1 + 1, col2 + 1)) == 0;
+}
+
+bool BitBoard::colSegmentClear(int col, int row1, int row2) const
+{
+    return (colBits[col + 1] & bitsBetween(row1 + 1, row2 + 1)) == 0;
+}
+
+uint64_t BitBoard::horizontalReach(int row, int col) const
+{
+    // 同一行内从 (row, col) 出发能直线走到的列（含自身），位下标为带哨兵的列号
+    return bitsRange(rayLeft(row, col) + 2, rayRight(row, col));
+}
+
+uint64_t BitBoard::verticalReach(int row, int col) const
+{
+    return bitsRange(rayUp(row, col) + 2, rayDown(row, col));
+}
+
+namespace {
+
+// 在一行（或一列）内，从 seeds 中的空格出发沿空格向两侧扩展，返回经过的空格和两侧停下的被占用格子
+// 向高位用加法的进位一次走完，向低位用倍增移位
+uint64_t spread(uint64_t seeds, uint64_t occupied)
+{
+    uint64_t empty = ~occupied;
+    uint64_t up = ((empty + seeds) ^ empty) | seeds;
+    uint64_t down = seeds;
+    uint64_t open = empty;
+    for (int shift = 1; shift < 64; shift *= 2) {
+        down |= open & (down >> shift);
+        open &= open >> shift;
+    }
+    return up | down | ((down >> 1) & occupied);
+}
+
+// 从第 line 行（或列）的 start 出发竖直（或水平）前进，在每一行（或列）上展开
+// start 中的位可以是被占用的起点自身，它只能作为出发点，不能作为中途经过的格子
+void sweep(const uint64_t *lines, int count, int line, uint64_t start, uint64_t *reach)
+{
+    for (int i = 0; i < count; ++i) {
+        reach[i] = 0;
+    }
+    reach[line] = start | (((start << 1) | (start >> 1)) & lines[line]);  // 不转弯，start 就是整段空格
+    for (int step = -1; step <= 1; step += 2) {
+        uint64_t through = start;
+        for (int i = line + step; i >= 0 && i < count && through; i += step) {
+            reach[i] |= (through & lines[i]) | spread(through & ~lines[i], lines[i]);
+            through &= ~lines[i];
+        }
+    }
+}
+
+}
+
+void BitBoard::linkReach(int row, int col, uint64_t *rowReach, uint64_t *colReach) const
+{
+    sweep(rowBits.data(), numRows + 2, row + 1, horizontalReach(row, col), rowReach);
+    sweep(colBits.data(), numCols + 2, col + 1, verticalReach(row, col), colReach);
+}
+
+bool BitBoard::canLink(int row1, int col1, int row2, int col2) const
+{
+    int corners[4][2];
+    return findLink(row1, col1, row2, col2, corners) > 0;
+}
+
+int BitBoard::findLink(int row1, int col1, int row2, int col2, int corners[4][2]) const
+{
+    if (row1 == row2 && col1 == col2) {
+        return 0;
+    }
+
+    // 任何不超过两个转折的路线都是“横-竖-横”或“竖-横-竖”（某些段长度可以为 0）
+    // 横-竖-横：经过第 k 列，两端各自能横向走到第 k 列，且第 k 列在两行之间没有障碍
+    int k = -1;
+    bool horizontalFirst = true;
+    uint64_t candidates = horizontalReach(row1, col1) & horizontalReach(row2, col2);
+    while (candidates) {
+        int col = lowestBit(candidates) - 1;
+        candidates &= candidates - 1;
+        if (colSegmentClear(col, row1, row2)) {
+            k = col;
+            break;
+        }
+    }
+
+    // 竖-横-竖：经过第 k 行
+    if (k < 0) {
+        horizontalFirst = false;
+        candidates = verticalReach(row1, col1) & verticalReach(row2, col2);
+        while (candidates) {
+            int row = lowestBit(candidates) - 1;
+            candidates &= candidates - 1;
+            if (rowSegmentClear(row, col1, col2)) {
+                k = row;
+                break;
+            }
+        }
+    }
+
+    if (k < 0) {
+        return 0;
+    }
+
+    int points[4][2];
+    points[0][0] = row1;
+    points[0][1] = col1;
+    if (horizontalFirst) {
+        points[1][0] = row1;
+        points[1][1] = k;
+        points[2][0] = row2;
+        points[2][1] = k;
+    } else {
+        points[1][0] = k;
+        points[1][1] = col1;
+        points[2][0] = k;
+        points[2][1] = col2;
+    }
+    points[3][0] = row2;
+    points[3][1] = col2;
+
+    // 去掉长度为 0 的线段
+    int count = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (count > 0 && corners[count - 1][0] == points[i][0] && corners[count - 1][1] == points[i][1]) {
+            continue;
+        }
+        corners[count][0] = points[i][0];
+        corners[count][1] = points[i][1];
+        ++count;
+    }
+    return count;
+}
@@ -0,0 +1,159 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include "cellgrid.h"
+#include <array>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// 最低位 1 的下标，x 不能为 0
+inline int lowestBit(uint64_t x)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+// 最高位 1 的下标，x 不能为 0
+inline int highestBit(uint64_t x)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(x);
+#endif
+}
+
+// 下标在 (from, to) 之间（不含两端）的位
+inline uint64_t bitsBetween(int from, int to)
+{
+    if (from > to) {
+        int t = from;
+        from = to;
+        to = t;
+    }
+    if (to - from < 2) {
+        return 0;
+    }
+    return ((uint64_t(1) << to) - 1) & ~((uint64_t(2) << from) - 1);
+}
+
+// 下标在 [from, to] 之间（包含两端）的位
+inline uint64_t bitsRange(int from, int to)
+{
+    uint64_t high = (to >= 63) ? ~uint64_t(0) : ((uint64_t(1) << (to + 1)) - 1);
+    return high & ~((uint64_t(1) << from) - 1);
+}
+
+// 棋盘的位表示：每一行、每一列各一个占用掩码，每种方块类型各一组行掩码
+// 位下标使用 CellGrid 中带哨兵的坐标（逻辑坐标 + 1），哨兵格子视为占用，
+// 因此射线一定会停下来；带哨兵的宽和高都不能超过 64
+class BitBoard
+{
+public:
+    static constexpr int MAX_DIM = 64;
+    static constexpr int MAX_TYPES = 16;
+
+    BitBoard();
+
+    void reset(const CellGrid &grid);
+    void update(const CellGrid &grid, int index);
+
+    int rows() const { return numRows; }
+    int cols() const { return numCols; }
+
+    // 以下接口都使用逻辑坐标，-1 和 rows/cols 表示哨兵
+    uint64_t rowMask(int row) const { return rowBits[row + 1]; }
+    uint64_t colMask(int col) const { return colBits[col + 1]; }
+    uint64_t typeRowMask(int type, int row) const { return typeRows[type][row + 1]; }
+    uint64_t typeColMask(int type, int col) const { return typeCols[type][col + 1]; }
+    bool isOccupied(int row, int col) const { return (rowBits[row + 1] >> (col + 1)) & 1; }
+
+    // 沿某个方向前进时遇到的第一个被占用格子的行/列
+    int rayLeft(int row, int col) const;
+    int rayRight(int row, int col) const;
+    int rayUp(int row, int col) const;
+    int rayDown(int row, int col) const;
+
+    // 两点之间（不含两端）是否没有障碍
+    bool rowSegmentClear(int row, int col1, int col2) const;
+    bool colSegmentClear(int col, int row1, int row2) const;
+
+    // 两个格子能否用不超过两个转折的路线连接（不检查方块类型）
+    bool canLink(int row1, int col1, int row2, int col2) const;
+    // 同上，并给出路线的拐点（含起点和终点），返回拐点个数，不能连接时返回 0
+    int findLink(int row1, int col1, int row2, int col2, int corners[4][2]) const;
+
+    // 从 (row, col) 出发不超过两个转折能到达的所有格子，下标和位都使用带哨兵的坐标：
+    // rowReach[r] 为中间一段是竖线的路线（横-竖-横）在第 r 行能到达的列，
+    // colReach[c] 为中间一段是横线的路线（竖-横-竖）在第 c 列能到达的行
+    void linkReach(int row, int col, uint64_t *rowReach, uint64_t *colReach) const;
+
+    // 一次找出所有可以消除的同类方块对，每对只访问一次，参数为逻辑坐标
+    // 每个方块只展开一次可达范围，再与同类方块的行、列掩码求交，不需要逐对检查
+    template <typename F>
+    void forEachLinkablePair(F visit) const;
+
+private:
+    uint64_t horizontalReach(int row, int col) const;
+    uint64_t verticalReach(int row, int col) const;
+
+    int numRows;
+    int numCols;
+    std::array<uint64_t, MAX_DIM> rowBits;
+    std::array<uint64_t, MAX_DIM> colBits;
+    std::array<std::array<uint64_t, MAX_DIM>, MAX_TYPES> typeRows;
+    std::array<std::array<uint64_t, MAX_DIM>, MAX_TYPES> typeCols;
+};
+
+template <typename F>
+void BitBoard::forEachLinkablePair(F visit) const
+{
+    uint64_t rowReach[MAX_DIM];
+    uint64_t colReach[MAX_DIM];
+    for (int type = 0; type < MAX_TYPES; ++type) {
+        for (int r = 1; r <= numRows; ++r) {
+            uint64_t blocks = typeRows[type][r];
+            while (blocks) {
+                int c = lowestBit(blocks);
+                blocks &= blocks - 1;
+                linkReach(r - 1, c - 1, rowReach, colReach);
+
+                // 只向行优先顺序靠后的方块配对，避免重复
+                uint64_t partners = rowReach[r] & typeRows[type][r] & ~((uint64_t(2) << c) - 1);
+                for (int r2 = r; r2 <= numRows; ++r2) {
+                    while (partners) {
+                        int c2 = lowestBit(partners);
+                        partners &= partners - 1;
+                        visit(r - 1, c - 1, r2 - 1, c2 - 1);
+                    }
+                    partners = rowReach[r2 + 1] & typeRows[type][r2 + 1];
+                }
+
+                // 竖-横-竖能到达、横-竖-横到达不了的方块
+                for (int c2 = 1; c2 <= numCols; ++c2) {
+                    uint64_t rows = colReach[c2] & typeCols[type][c2];
+                    rows &= c2 > c ? ~((uint64_t(1) << r) - 1) : ~((uint64_t(2) << r) - 1);
+                    while (rows) {
+                        int r2 = lowestBit(rows);
+                        rows &= rows - 1;
+                        if (!((rowReach[r2] >> c2) & 1)) {
+                            visit(r - 1, c - 1, r2 - 1, c2 - 1);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif // BITBOARD_H
@@ -0,0 +1,1188 @@
+#include "board.h"
+#include "difficulty.h"
+#include "fixedboard.h"
+#include "solver.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
+
+Board::Board(bool isTwoPlayerMode)
+    : twoPlayerMode(isTwoPlayerMode), outerGridMutations(0), numBlocks(0), numProps(0),
+    player1Score(0), player2Score(0), timeLeft(GAME_DURATION),
+    player1Position{0, 0}, player2Position{0, 0},
+    mutations(1), routeCache{}, routeCacheNext(0), pairIndexValid(false), emptySetsValid(false),
+    patternDeadlock(Deadlock::None), patternMutations(0), solverDeadlock(false), solverMutations(0),
+    rng(std::random_device{}())
+{
+    resize(GRID_SIZE, GRID_SIZE);
+}
+
+bool Board::isValidLinkRule(const LinkRule &value)
+{
+    return value.maxTurns == UNLIMITED_TURNS || (value.maxTurns >= 0 && value.maxTurns <= MAX_TURNS);
+}
+
+void Board::setLinkRule(const LinkRule &value)
+{
+    if (!isValidLinkRule(value)) {
+        throw std::invalid_argument("Invalid link rule.");
+    }
+    rule = value;
+    ++mutations;  // 缓存的路线作废
+    pairIndexValid = false;
+}
+
+void Board::seed(unsigned int value)
+{
+    rng.seed(value);
+}
+
+int Board::randomInt(int bound)
+{
+    return std::uniform_int_distribution<int>(0, bound - 1)(rng);
+}
+
+bool Board::contains(int row, int col) const
+{
+    return row >= 0 && row < grid.rows() && col >= 0 && col < grid.cols();
+}
+
+void Board::resize(int rows, int cols)
+{
+    if (rows <= 0 || rows > MAX_SIZE || cols <= 0 || cols > MAX_SIZE) {
+        throw std::invalid_argument("Invalid board size.");
+    }
+    grid.reset(rows, cols);
+    ++mutations;
+    bits.reset(grid);
+    rays.reset(grid);
+    propTypes.assign(grid.size(), static_cast<uint8_t>(PropType::None));
+    for (auto &cells : typeCells) {
+        cells.reset(grid.size());
+    }
+    emptyCells.reset(grid.size());
+    recount();
+    pairIndex.reset(grid.size());
+    pairIndexValid = false;
+    affectedBlocks.reset(grid.size());
+    emptySetsValid = false;
+    changedMark.assign(grid.size(), 0);
+    pending.cells.clear();
+    pending.layout = true;
+}
+
+void Board::markCell(int index)
+{
+    if (!changedMark[index]) {
+        changedMark[index] = 1;
+        pending.cells.push_back({grid.rowOf(index), grid.colOf(index)});
+    }
+}
+
+Board::ChangeSet Board::takeChanges()
+{
+    for (const Point &cell : pending.cells) {
+        changedMark[grid.index(cell.row, cell.col)] = 0;
+    }
+    ChangeSet result = std::move(pending);
+    pending = ChangeSet();
+    return result;
+}
+
+void Board::recount()
+{
+    numBlocks = 0;
+    numProps = 0;
+    emptyCells.clear();
+    for (int i = 0; i < grid.size(); ++i) {
+        numBlocks += grid.isBlock(i);
+        numProps += grid.code(i) == CellGrid::CODE_PROP;
+        if (grid.isEmpty(i)) {
+            emptyCells.insert(i);
+        }
+    }
+}
+
+bool Board::verifyCounters() const
+{
+    int blocks = 0, empty = 0, props = 0;
+    std::array<int, MAX_BLOCK_TYPES> perType{};
+    for (int i = 0; i < grid.size(); ++i) {
+        if (grid.isBlock(i)) {
+            int type = grid.code(i) - CellGrid::CODE_BLOCK;
+            if (!typeCells[type].contains(i)) {
+                return false;
+            }
+            ++perType[type];
+            ++blocks;
+        }
+        if (grid.isEmpty(i) != emptyCells.contains(i)) {
+            return false;
+        }
+        empty += grid.isEmpty(i);
+        props += grid.code(i) == CellGrid::CODE_PROP;
+    }
+    for (int type = 0; type < MAX_BLOCK_TYPES; ++type) {
+        if (perType[type] != typeCells[type].size()) {
+            return false;
+        }
+    }
+    return blocks == numBlocks && empty == emptyCells.size() && props == numProps;
+}
+
+void Board::rebuildTypeCells()
+{
+    for (auto &cells : typeCells) {
+        cells.clear();
+    }
+    for (int i = 0; i < grid.size(); ++i) {
+        if (grid.isBlock(i)) {
+            typeCells[grid.code(i) - CellGrid::CODE_BLOCK].insert(i);
+        }
+    }
+}
+
+void Board::writeCell(int index, uint8_t code)
+{
+    uint8_t old = grid.code(index);
+    bool wasBlock = grid.isBlock(index);
+    bool isBlock = code >= CellGrid::CODE_BLOCK && code != CellGrid::CODE_WALL;
+    numBlocks += isBlock - wasBlock;
+    numProps += (code == CellGrid::CODE_PROP) - (old == CellGrid::CODE_PROP);
+    if (wasBlock) {
+        typeCells[old - CellGrid::CODE_BLOCK].erase(index);
+    }
+    if (isBlock) {
+        typeCells[code - CellGrid::CODE_BLOCK].insert(index);
+    }
+    if (code == CellGrid::CODE_EMPTY) {
+        emptyCells.insert(index);
+    } else {
+        emptyCells.erase(index);
+    }
+    if (code != CellGrid::CODE_PROP) {
+        propTypes[index] = static_cast<uint8_t>(PropType::None);
+    }
+    if (pairIndexValid && old != code) {
+        // 腾出格子只会增加可以连接的对；占用格子可能让已有的连接断开，只能重建
+        if (wasBlock) {
+            pairIndex.removeCell(index);
+        }
+        if (code != CellGrid::CODE_EMPTY) {
+            pairIndexValid = false;
+        }
+    }
+    grid.setCode(index, code);
+    ++mutations;
+    bits.update(grid, index);
+    if ((old == CellGrid::CODE_EMPTY) != (code == CellGrid::CODE_EMPTY)) {
+        rays.update(grid, index);
+        if (pairIndexValid && code == CellGrid::CODE_EMPTY) {
+            // 增量补充只适用于默认规则，其它规则下重建
+            if (isDefaultRule()) {
+                addPairsAround(index);
+            } else {
+                pairIndexValid = false;
+            }
+        }
+        if (emptySetsValid && code == CellGrid::CODE_EMPTY) {
+            const int *offsets = grid.neighbourOffsets();
+            for (int i = 0; i < 4; ++i) {
+                if (grid.isEmpty(index + offsets[i])) {
+                    emptySets.unite(index, index + offsets[i]);
+                }
+            }
+        } else {
+            emptySetsValid = false;
+        }
+    }
+    markCell(index);
+}
+
+void Board::setCell(int row, int col, int value)
+{
+    if (value < PROP || value >= MAX_BLOCK_TYPES) {
+        throw std::invalid_argument("Invalid cell value.");
+    }
+    writeCell(grid.index(row, col), CellGrid::encode(value));
+}
+
+void Board::generateMap()
+{
+    buildMap(PROP_PERCENT);
+}
+
+bool Board::generateMap(Difficulty difficulty, int threads)
+{
+    // 道具会挡住路线，道具越多越难：先按难度选一个道具比例，生成后用模拟对局评分，
+    // 不在区间内就朝区间的方向调整比例重新生成；都不在区间内时留下离区间最近的一张
+    DifficultyRater::Band band = DifficultyRater::band(difficulty);
+    int propPercent = difficulty == Difficulty::Easy ? PROP_PERCENT / 2 :
+                      difficulty == Difficulty::Normal ? PROP_PERCENT : PROP_PERCENT * 2;
+    DifficultyRater rater;
+    DifficultyRater::Limits limits;
+    limits.playouts = RATING_PLAYOUTS;
+    limits.threads = threads;
+    CellGrid bestGrid;
+    std::vector<uint8_t> bestProps;
+    double bestDistance = -1;
+    for (int attempt = 0; attempt < GENERATE_CANDIDATES; ++attempt) {
+        buildMap(propPercent);
+        limits.seed = rng();
+        double score = rater.rate(*this, limits).score;
+        if (band.contains(score)) {
+            return true;
+        }
+        double distance = score < band.low ? band.low - score : score - band.high;
+        if (bestDistance < 0 || distance < bestDistance) {
+            bestDistance = distance;
+            bestGrid = grid;
+            bestProps = propTypes;
+        }
+        propPercent += score < band.low ? PROP_PERCENT_STEP : -PROP_PERCENT_STEP;
+        propPercent = std::clamp(propPercent, 0, MAX_PROP_PERCENT);
+    }
+    grid = bestGrid;
+    propTypes = bestProps;
+    finishMap();
+    return false;
+}
+
+void Board::buildMap(int propPercent)
+{
+    // 倒着搭建：从空地图开始，每次把一对同类方块放在此刻能连上的两块空地上
+    // 之后只会放得更满，所以按放置的相反顺序消除时每一对都能连上，生成的地图一定能消完
+    int rows = grid.rows();
+    int cols = grid.cols();
+    int totalCells = (rows - 2) * (cols - 2);  // 不包括边界
+    int propCount = totalCells * propPercent / 100;
+
+    std::vector<int> interior;
+    interior.reserve(totalCells);
+    propTypes.assign(grid.size(), static_cast<uint8_t>(PropType::None));
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            grid.setValue(i, j, EMPTY);  // 边界上没有方块
+            if (i > 0 && i < rows - 1 && j > 0 && j < cols - 1) {
+                interior.push_back(grid.index(i, j));
+            }
+        }
+    }
+
+    // 道具一直留在地图上，最先放
+    std::shuffle(interior.begin(), interior.end(), rng);
+    SparseCellSet freeCells;
+    freeCells.reset(grid.size());
+    for (int i = 0; i < totalCells; ++i) {
+        if (i < propCount) {
+            grid.setCode(interior[i], CellGrid::CODE_PROP);
+            propTypes[interior[i]] = static_cast<uint8_t>(randomPropType());
+        } else {
+            freeCells.insert(interior[i]);
+        }
+    }
+    bits.reset(grid);
+
+    std::vector<uint8_t> codes(freeCells.size() / 2);
+    for (uint8_t &code : codes) {
+        code = static_cast<uint8_t>(CellGrid::CODE_BLOCK + randomInt(BLOCK_TYPES));
+    }
+    std::vector<int> leftover;
+    placePairsInReverse(&freeCells, codes, &leftover);  // 剩下的格子留空
+    finishMap();
+}
+
+void Board::finishMap()
+{
+    // 直接改写了整张网格，重建所有索引和计数
+    ++mutations;
+    bits.reset(grid);
+    rays.reset(grid);
+    rebuildTypeCells();
+    recount();
+    pairIndexValid = false;
+    emptySetsValid = false;
+    pending.layout = true;
+}
+
+int Board::placePairsInReverse(SparseCellSet *freeCells, const std::vector<uint8_t> &codes, std::vector<int> *leftover)
+{
+    // freeCells 中的格子此刻都是空地，依次把 codes 中的编码成对放在此刻能连上的两块空地上
+    // 之后只会放得更满，按放置的相反顺序消除时每一对都能连上；没能放下的格子写入 leftover，返回放下的对数
+    // 没有相邻的待填空地、又不挨着地图边界的空地再也连不上任何格子，只能留空；为了少留空：
+    // 只剩一个空邻居的空地优先选作第一块，第二块避开会让别的空地失去最后一个空邻居的格子
+    // 挨着边界的格子永远有路可走，空邻居数直接记为 SAFE，不会被困住
+    const int *offsets = grid.neighbourOffsets();
+    const int SAFE = 4;
+    std::vector<int> freeNeighbours(grid.size(), 0);
+    SparseCellSet critical;
+    critical.reset(grid.size());
+    for (int index : *freeCells) {
+        for (int i = 0; i < 4; ++i) {
+            int neighbour = index + offsets[i];
+            if (freeCells->contains(neighbour)) {
+                ++freeNeighbours[index];
+            } else if (grid.isEmpty(neighbour)) {
+                freeNeighbours[index] += SAFE;
+            }
+        }
+        if (freeNeighbours[index] <= 1) {
+            critical.insert(index);
+        }
+    }
+    auto adjacent = [&](int a, int b) {
+        return a - b == 1 || b - a == 1 || a - b == grid.stride() || b - a == grid.stride();
+    };
+    // 同时占用 cell 和 other 后，cell 旁边是否有空地被困住
+    auto traps = [&](int cell, int other) {
+        for (int i = 0; i < 4; ++i) {
+            int neighbour = cell + offsets[i];
+            if (neighbour != other && freeCells->contains(neighbour) &&
+                freeNeighbours[neighbour] - 1 - (adjacent(neighbour, other) ? 1 : 0) <= 0) {
+                return true;
+            }
+        }
+        return false;
+    };
+    auto take = [&](int index) {
+        freeCells->erase(index);
+        critical.erase(index);
+        for (int i = 0; i < 4; ++i) {
+            int neighbour = index + offsets[i];
+            if (freeCells->contains(neighbour) && --freeNeighbours[neighbour] <= 1) {
+                critical.insert(neighbour);
+            }
+        }
+    };
+
+    std::vector<int> candidates;
+    std::size_t next = 0;
+    while (freeCells->size() >= 2 && next < codes.size()) {
+        const SparseCellSet &pool = critical.empty() ? *freeCells : critical;
+        int first = pool[randomInt(pool.size())];
+        int second = -1;
+        // 只剩 first 这一个空邻居的空地必须和 first 配对
+        for (int i = 0; i < 4 && second < 0; ++i) {
+            int neighbour = first + offsets[i];
+            if (freeCells->contains(neighbour) && freeNeighbours[neighbour] == 1) {
+                second = neighbour;
+            }
+        }
+        if (second < 0) {
+            collectLinkableCells(first, *freeCells, &candidates);
+            auto safe = std::partition(candidates.begin(), candidates.end(), [&](int cell) {
+                return !traps(cell, first) && !traps(first, cell);
+            });
+            int count = static_cast<int>(safe - candidates.begin());
+            if (count == 0) {
+                count = static_cast<int>(candidates.size());
+            }
+            if (count > 0) {
+                second = candidates[randomInt(count)];
+            }
+        }
+        take(first);
+        if (second < 0) {
+            leftover->push_back(first);  // 地图只会越来越满，这块空地以后也连不上
+            continue;
+        }
+        take(second);
+        grid.setCode(first, codes[next]);
+        grid.setCode(second, codes[next]);
+        bits.update(grid, first);
+        bits.update(grid, second);
+        ++next;
+    }
+    leftover->insert(leftover->end(), freeCells->begin(), freeCells->end());
+    return static_cast<int>(next);
+}
+
+void Board::collectLinkableCells(int first, const SparseCellSet &freeCells, std::vector<int> *candidates) const
+{
+    // freeCells 中此刻能和 first 连接的格子，两端都还是空地
+    // 允许两个以上转折时，两个转折能连上的也一定能连上，都按默认规则用位棋盘一次展开
+    candidates->clear();
+    if (rule.maxTurns == UNLIMITED_TURNS || rule.maxTurns >= 2) {
+        uint64_t rowReach[BitBoard::MAX_DIM];
+        uint64_t colReach[BitBoard::MAX_DIM];
+        bits.linkReach(grid.rowOf(first), grid.colOf(first), rowReach, colReach);
+        for (int r = 1; r <= grid.rows(); ++r) {
+            for (uint64_t mask = rowReach[r]; mask; mask &= mask - 1) {
+                int index = grid.index(r - 1, lowestBit(mask) - 1);
+                if (index != first && freeCells.contains(index)) {
+                    candidates->push_back(index);
+                }
+            }
+        }
+        for (int c = 1; c <= grid.cols(); ++c) {
+            for (uint64_t mask = colReach[c]; mask; mask &= mask - 1) {
+                int r = lowestBit(mask);
+                int index = grid.index(r - 1, c - 1);
+                if (index != first && freeCells.contains(index) && !((rowReach[r] >> c) & 1)) {
+                    candidates->push_back(index);
+                }
+            }
+        }
+    } else {
+        for (int index : freeCells) {
+            if (index != first && finder.connected(grid, first, index, rule.maxTurns)) {
+                candidates->push_back(index);
+            }
+        }
+    }
+
+}
+
+bool Board::shuffleBlocks(ShuffleMode mode)
+{
+    // 方块所在的格子不变，只重新分配类型；codes[i] 放到 cells[i]
+    std::vector<int> cells;
+    std::vector<uint8_t> original;
+    for (int i = 0; i < grid.size(); ++i) {
+        if (grid.isBlock(i)) {
+            cells.push_back(i);
+            original.push_back(grid.code(i));
+        }
+    }
+    std::vector<uint8_t> codes = original;
+    std::shuffle(codes.begin(), codes.end(), rng);
+
+    bool guaranteed = mode == ShuffleMode::Any;
+    if (mode == ShuffleMode::Solvable) {
+        guaranteed = arrangeSolvable(cells, &codes);
+        // 倒着放不满所有格子时，再随机打乱几次，由求解器在小预算内确认能消完
+        Solver::Limits limits;
+        limits.maxNodes = SHUFFLE_SOLVER_NODES;
+        limits.maxMilliseconds = SHUFFLE_SOLVER_MILLISECONDS;
+        for (int attempt = 0; attempt < SHUFFLE_ATTEMPTS && !guaranteed; ++attempt) {
+            std::shuffle(codes.begin(), codes.end(), rng);
+            writeBlockCodes(cells, codes);
+            guaranteed = Solver().solve(*this, limits) == Solver::Result::Solvable;
+        }
+    }
+    if (mode == ShuffleMode::Playable || (mode == ShuffleMode::Solvable && !guaranteed)) {
+        // 做不到整局可解时至少保证有一对能消除
+        bool playable = arrangePlayable(cells, &codes);
+        guaranteed = guaranteed || (mode == ShuffleMode::Playable && playable);
+    }
+
+    writeBlockCodes(cells, codes);
+    for (std::size_t i = 0; i < cells.size(); ++i) {
+        if (codes[i] != original[i]) {
+            markCell(cells[i]);
+        }
+    }
+    return guaranteed;
+}
+
+void Board::writeBlockCodes(const std::vector<int> &cells, const std::vector<uint8_t> &codes)
+{
+    for (std::size_t i = 0; i < cells.size(); ++i) {
+        grid.setCode(cells[i], codes[i]);
+    }
+    ++mutations;
+    bits.reset(grid);
+    rebuildTypeCells();
+    pairIndexValid = false;
+}
+
+bool Board::arrangePlayable(const std::vector<int> &cells, std::vector<uint8_t> *codes)
+{
+    // 按随机顺序找一个方块格子，它能连上另一个方块格子（不看类型）时，把同一种类型放到这两格上
+    if (codes->empty()) {
+        return true;
+    }
+    int counts[MAX_BLOCK_TYPES] = {};
+    for (uint8_t code : *codes) {
+        ++counts[code - CellGrid::CODE_BLOCK];
+    }
+    auto paired = std::find_if(codes->begin(), codes->end(), [&counts](uint8_t code) {
+        return counts[code - CellGrid::CODE_BLOCK] >= 2;
+    });
+    if (paired == codes->end()) {
+        return false;
+    }
+    uint8_t code = *paired;
+
+    SparseCellSet occupied;
+    occupied.reset(grid.size());
+    std::vector<int> slot(grid.size(), -1);
+    for (std::size_t i = 0; i < cells.size(); ++i) {
+        occupied.insert(cells[i]);
+        slot[cells[i]] = static_cast<int>(i);
+    }
+    std::vector<int> order(cells.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        order[i] = static_cast<int>(i);
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+
+    std::vector<int> candidates;
+    for (int first : order) {
+        collectLinkableCells(cells[first], occupied, &candidates);
+        if (candidates.empty()) {
+            continue;
+        }
+        int second = slot[candidates[randomInt(static_cast<int>(candidates.size()))]];
+        std::swap(*std::find(codes->begin(), codes->end(), code), (*codes)[first]);
+        for (std::size_t i = 0; i < codes->size(); ++i) {
+            if (static_cast<int>(i) != first && (*codes)[i] == code) {
+                std::swap((*codes)[i], (*codes)[second]);
+                break;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+bool Board::arrangeSolvable(const std::vector<int> &cells, std::vector<uint8_t> *codes)
+{
+    // 把方块格子当作空地，按 generateMap 的方法倒着放回同样的方块：放得下就一定能消完
+    // 某种方块剩奇数个，或者有格子放不下时返回 false，地图保持原样
+    int counts[MAX_BLOCK_TYPES] = {};
+    for (uint8_t code : *codes) {
+        ++counts[code - CellGrid::CODE_BLOCK];
+    }
+    std::vector<uint8_t> pairCodes;
+    for (int type = 0; type < MAX_BLOCK_TYPES; ++type) {
+        if (counts[type] % 2 != 0) {
+            return false;
+        }
+        pairCodes.insert(pairCodes.end(), counts[type] / 2, static_cast<uint8_t>(CellGrid::CODE_BLOCK + type));
+    }
+    std::shuffle(pairCodes.begin(), pairCodes.end(), rng);
+
+    std::vector<uint8_t> saved(cells.size());
+    SparseCellSet freeCells;
+    freeCells.reset(grid.size());
+    for (std::size_t i = 0; i < cells.size(); ++i) {
+        saved[i] = grid.code(cells[i]);
+        grid.setCode(cells[i], CellGrid::CODE_EMPTY);
+        bits.update(grid, cells[i]);
+        freeCells.insert(cells[i]);
+    }
+
+    std::vector<int> leftover;
+    placePairsInReverse(&freeCells, pairCodes, &leftover);
+    bool placed = leftover.empty();
+    for (std::size_t i = 0; i < cells.size(); ++i) {
+        if (placed) {
+            (*codes)[i] = grid.code(cells[i]);
+        }
+        grid.setCode(cells[i], saved[i]);
+        bits.update(grid, cells[i]);
+    }
+    return placed;
+}
+
+bool Board::isMapSolvable() const
+{
+    Solver solver;
+    return solver.solve(*this) != Solver::Result::Unsolvable;
+}
+
+Board::Deadlock Board::findDeadlock(int maxMilliseconds) const
+{
+    if (patternMutations != mutations) {
+        patternDeadlock = Deadlock::None;
+        for (int type = 0; type < MAX_BLOCK_TYPES && patternDeadlock == Deadlock::None; ++type) {
+            patternDeadlock = deadlockOfType(type);
+        }
+        patternMutations = mutations;
+    }
+    if (patternDeadlock != Deadlock::None || maxMilliseconds <= 0) {
+        return patternDeadlock;
+    }
+
+    // 形状都不匹配时用求解器兜底；预算内没有结论按不是死局处理
+    if (solverMutations != mutations) {
+        Solver::Limits limits;
+        limits.maxMilliseconds = maxMilliseconds;
+        solverDeadlock = Solver().solve(*this, limits) == Solver::Result::Unsolvable;
+        solverMutations = mutations;
+    }
+    return solverDeadlock ? Deadlock::Proven : Deadlock::None;
+}
+
+Board::Deadlock Board::deadlockOfType(int type) const
+{
+    // 只看这一种方块的格子，以及夹在它们之间、与它们交叉的另一种方块
+    const SparseCellSet &cells = typeCells[type];
+    if (cells.size() % 2 != 0) {
+        return Deadlock::OddCount;
+    }
+    if (rule.maxTurns == 0) {
+        // 不允许转折时只能和同一行或同一列的同类方块相连
+        for (int a : cells) {
+            bool partner = false;
+            for (int b : cells) {
+                if (b != a && (grid.rowOf(a) == grid.rowOf(b) || grid.colOf(a) == grid.colOf(b))) {
+                    partner = true;
+                    break;
+                }
+            }
+            if (!partner) {
+                return Deadlock::Stranded;
+            }
+        }
+        if (cells.size() == 2 && sameTypePairBetween(cells[0], cells[1])) {
+            return Deadlock::Interleaved;
+        }
+    }
+    if (cells.size() == 2 && rule.maxTurns != UNLIMITED_TURNS && rule.maxTurns <= 2) {
+        // 对角相邻的两格只能经过另两个角相连，绕开它们至少要三个转折
+        int a = cells[0];
+        int b = cells[1];
+        int rowA = grid.rowOf(a), colA = grid.colOf(a);
+        int rowB = grid.rowOf(b), colB = grid.colOf(b);
+        if (std::abs(rowA - rowB) == 1 && std::abs(colA - colB) == 1) {
+            int c = grid.index(rowA, colB);
+            int d = grid.index(rowB, colA);
+            if (grid.isBlock(c) && grid.code(c) == grid.code(d) &&
+                typeCells[grid.code(c) - CellGrid::CODE_BLOCK].size() == 2) {
+                return Deadlock::Crossed;
+            }
+        }
+    }
+    return Deadlock::None;
+}
+
+bool Board::sameTypePairBetween(int first, int second) const
+{
+    // first 和 second 在同一行（列）上；中间有一种只剩两个的方块，另一个在这条线上 [first, second] 之外时，
+    // 两种方块都要等对方先消掉
+    if (first > second) {
+        std::swap(first, second);
+    }
+    int step = grid.rowOf(first) == grid.rowOf(second) ? 1 : grid.stride();
+    for (int index = first + step; index < second; index += step) {
+        if (!grid.isBlock(index)) {
+            continue;
+        }
+        const SparseCellSet &others = typeCells[grid.code(index) - CellGrid::CODE_BLOCK];
+        if (others.size() != 2) {
+            continue;
+        }
+        int other = others[0] == index ? others[1] : others[0];
+        bool sameLine = step == 1 ? grid.rowOf(other) == grid.rowOf(first) : grid.colOf(other) == grid.colOf(first);
+        if (sameLine && (other < first || other > second)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Board::PropType Board::propAt(int row, int col) const
+{
+    int index = grid.index(row, col);
+    if (grid.code(index) != CellGrid::CODE_PROP) {
+        return PropType::None;
+    }
+    return static_cast<PropType>(propTypes[index]);
+}
+
+void Board::addProp(PropType type, int row, int col)
+{
+    int index = grid.index(row, col);
+    writeCell(index, CellGrid::CODE_PROP);
+    propTypes[index] = static_cast<uint8_t>(type);
+}
+
+Board::PropType Board::takeProp(int row, int col)
+{
+    PropType type = propAt(row, col);
+    writeCell(grid.index(row, col), CellGrid::CODE_EMPTY);
+    return type;
+}
+
+void Board::clearProps()
+{
+    for (int i = 0; i < grid.size() && numProps > 0; ++i) {
+        if (grid.code(i) == CellGrid::CODE_PROP) {
+            writeCell(i, CellGrid::CODE_EMPTY);
+        }
+    }
+}
+
+std::vector<Board::PropType> Board::availableProps() const
+{
+    if (twoPlayerMode) {
+        return {PropType::PlusOneSecond, PropType::Shuffle, PropType::Hint, PropType::Freeze, PropType::Dizzy};
+    }
+    return {PropType::PlusOneSecond, PropType::Shuffle, PropType::Hint, PropType::Flash};
+}
+
+Board::PropType Board::randomPropType()
+{
+    std::vector<PropType> available = availableProps();
+    return available[randomInt(static_cast<int>(available.size()))];
+}
+
+bool Board::spawnProp(PropType type, Point *spot)
+{
+    // 从空地集合中等概率选一个位置放置道具
+    if (emptyCells.empty()) {
+        return false;
+    }
+    int index = emptyCells[randomInt(emptyCells.size())];
+    spot->row = grid.rowOf(index);
+    spot->col = grid.colOf(index);
+    addProp(type, spot->row, spot->col);
+    return true;
+}
+
+bool Board::isEmptyOrBorder(int row, int col) const
+{
+    return contains(row, col) && grid.isEmpty(grid.index(row, col));
+}
+
+bool Board::checkStraightLine(int row1, int col1, int row2, int col2) const
+{
+    if (row1 != row2 && col1 != col2) {
+        return false;
+    }
+    return rays.segmentClear(grid, grid.index(row1, col1), grid.index(row2, col2));
+}
+
+bool Board::connect(int row1, int col1, int row2, int col2, Route *route) const
+{
+    int from = grid.index(row1, col1);
+    int to = grid.index(row2, col2);
+
+    // 地图没有变化之前，同一对格子只搜索一次（两个方向共用）
+    for (const auto &entry : routeCache) {
+        if (entry.mutations == mutations &&
+            ((entry.from == from && entry.to == to) || (entry.from == to && entry.to == from))) {
+            if (route) {
+                if (entry.from == from) {
+                    route->assign(entry.route.begin(), entry.route.end());
+                } else {
+                    route->assign(entry.route.rbegin(), entry.route.rend());
+                }
+            }
+            return !entry.route.empty();
+        }
+    }
+
+    RouteCacheEntry &entry = routeCache[routeCacheNext];
+    routeCacheNext = (routeCacheNext + 1) % ROUTE_CACHE_SIZE;
+    entry.mutations = mutations;
+    entry.from = from;
+    entry.to = to;
+    entry.route.clear();
+
+    // 必须是两个不同的、相同类型的方块
+    if (from != to && grid.isBlock(from) && grid.code(from) == grid.code(to)) {
+        searchRoute(from, to, &entry.route);
+    }
+
+    if (route) {
+        route->assign(entry.route.begin(), entry.route.end());
+    }
+    return !entry.route.empty();
+}
+
+const CellGrid &Board::routingGrid() const
+{
+    if (!rule.allowOutside) {
+        return grid;
+    }
+    if (outerGridMutations != mutations) {
+        outerGrid.surround(grid);
+        outerGridMutations = mutations;
+    }
+    return outerGrid;
+}
+
+bool Board::searchRoute(int from, int to, Route *route) const
+{
+    // 默认规则用射线表的区间判断；其余规则按转折次数分层搜索，不限转折时逐格找最短路线
+    // 允许绕到地图外时在外面多一圈空地的网格上搜索
+    // 路线总是从下标较小的一端搜索，再按需要反转，保证两个方向、不同客户端得到同一条路线
+    bool reversed = from > to;
+    if (reversed) {
+        std::swap(from, to);
+    }
+    int corners[MAX_ROUTE_POINTS];
+    const int *points = corners;
+    int count;
+    const CellGrid &routing = routingGrid();
+    if (isDefaultRule()) {
+        count = rays.findLink(grid, from, to, corners);
+    } else {
+        if (rule.allowOutside) {
+            from = routing.index(grid.rowOf(from) + 1, grid.colOf(from) + 1);
+            to = routing.index(grid.rowOf(to) + 1, grid.colOf(to) + 1);
+        }
+        if (rule.maxTurns == UNLIMITED_TURNS) {
+            count = finder.shortest(routing, from, to, &cornerBuffer);
+            points = cornerBuffer.data();
+        } else {
+            count = finder.find(routing, from, to, rule.maxTurns, corners);
+        }
+    }
+
+    if (route) {
+        int offset = rule.allowOutside ? 1 : 0;
+        route->clear();
+        for (int i = 0; i < count; ++i) {
+            route->push_back({routing.rowOf(points[i]) - offset, routing.colOf(points[i]) - offset});
+        }
+        if (reversed) {
+            std::reverse(route->begin(), route->end());
+        }
+    }
+    return count > 0;
+}
+
+bool Board::canConnect(int row1, int col1, int row2, int col2) const
+{
+    return connect(row1, col1, row2, col2);
+}
+
+std::vector<Board::Point> Board::findPath(int row1, int col1, int row2, int col2) const
+{
+    // 路线只记录起点、拐点和终点
+    Route route;
+    connect(row1, col1, row2, col2, &route);
+    return route;
+}
+
+bool Board::reachable(int start, int target) const
+{
+    if (!emptySetsValid) {
+        emptySets.reset(grid.size());
+        for (int index : emptyCells) {
+            if (grid.isEmpty(index + 1)) {
+                emptySets.unite(index, index + 1);
+            }
+            if (grid.isEmpty(index + grid.stride())) {
+                emptySets.unite(index, index + grid.stride());
+            }
+        }
+        emptySetsValid = true;
+    }
+
+    if (start == target) {
+        return true;
+    }
+    if (!grid.isEmpty(target)) {
+        return false;
+    }
+    // 起点不是空地时（玩家可以站在方块上），从它四周的空地出发
+    int label = emptySets.find(target);
+    if (grid.isEmpty(start)) {
+        return emptySets.find(start) == label;
+    }
+    const int *offsets = grid.neighbourOffsets();
+    for (int i = 0; i < 4; ++i) {
+        int next = start + offsets[i];
+        if (grid.isEmpty(next) && emptySets.find(next) == label) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Board::canReachPosition(int startRow, int startCol, int endRow, int endCol) const
+{
+    return reachable(grid.index(startRow, startCol), grid.index(endRow, endCol));
+}
+
+bool Board::findFlashDestination(int startRow, int startCol, int row, int col, Point *destination) const
+{
+    int start = grid.index(startRow, startCol);
+    int target = grid.index(row, col);
+    if (grid.isEmpty(target)) {
+        if (!reachable(start, target)) {
+            return false;
+        }
+        *destination = {row, col};
+        return true;
+    }
+    if (!grid.isBlock(target)) {
+        return false;
+    }
+
+    const int *offsets = grid.neighbourOffsets();
+    for (int i = 0; i < 4; ++i) {
+        int next = target + offsets[i];
+        if (grid.isEmpty(next) && reachable(start, next)) {
+            *destination = {grid.rowOf(next), grid.colOf(next)};
+            return true;
+        }
+    }
+    return false;
+}
+
+const PairIndex &Board::linkablePairs() const
+{
+    if (!pairIndexValid) {
+        rebuildPairIndex();
+        pairIndexValid = true;
+    }
+    return pairIndex;
+}
+
+void Board::rebuildPairIndex() const
+{
+    pairIndex.clear();
+    if (isDefaultRule()) {
+        FixedKernels::forEachLinkablePair(*this, [this](int first, int second) {
+            pairIndex.addPair(first, second);
+        });
+        return;
+    }
+
+    const CellGrid &routing = routingGrid();
+    const int *offsets = routing.neighbourOffsets();
+    int offset = rule.allowOutside ? 1 : 0;
+    auto toRouting = [&](int index) {
+        return routing.index(grid.rowOf(index) + offset, grid.colOf(index) + offset);
+    };
+
+    if (rule.maxTurns != UNLIMITED_TURNS) {
+        for (const SparseCellSet &cells : typeCells) {
+            for (int i = 0; i < cells.size(); ++i) {
+                for (int j = i + 1; j < cells.size(); ++j) {
+                    if (finder.connected(routing, toRouting(cells[i]), toRouting(cells[j]), rule.maxTurns)) {
+                        pairIndex.addPair(cells[i], cells[j]);
+                    }
+                }
+            }
+        }
+        return;
+    }
+
+    // 不限转折时，两个方块能连接等价于相邻，或者各自旁边的某块空地属于同一个连通分量
+    std::vector<int> labels(routing.size(), -1);
+    std::vector<int> stack;
+    for (int start = 0; start < routing.size(); ++start) {
+        if (!routing.isEmpty(start) || labels[start] >= 0) {
+            continue;
+        }
+        labels[start] = start;
+        stack.push_back(start);
+        while (!stack.empty()) {
+            int cell = stack.back();
+            stack.pop_back();
+            for (int i = 0; i < 4; ++i) {
+                int next = cell + offsets[i];
+                if (routing.isEmpty(next) && labels[next] < 0) {
+                    labels[next] = start;
+                    stack.push_back(next);
+                }
+            }
+        }
+    }
+
+    auto linked = [&](int first, int second) {
+        for (int i = 0; i < 4; ++i) {
+            if (first + offsets[i] == second) {
+                return true;
+            }
+            int label = labels[first + offsets[i]];
+            for (int j = 0; j < 4 && label >= 0; ++j) {
+                if (labels[second + offsets[j]] == label) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+    for (const SparseCellSet &cells : typeCells) {
+        for (int i = 0; i < cells.size(); ++i) {
+            for (int j = i + 1; j < cells.size(); ++j) {
+                if (linked(toRouting(cells[i]), toRouting(cells[j]))) {
+                    pairIndex.addPair(cells[i], cells[j]);
+                }
+            }
+        }
+    }
+}
+
+std::vector<std::pair<Board::Point, Board::Point>> Board::findAllLinkablePairs() const
+{
+    const PairIndex &pairs = linkablePairs();
+    std::vector<std::pair<Point, Point>> result;
+    result.reserve(pairs.pairCount());
+    for (int cell : pairs.linkableCells()) {
+        for (int partner : pairs.partnersOf(cell)) {
+            if (cell < partner) {
+                result.push_back({{grid.rowOf(cell), grid.colOf(cell)}, {grid.rowOf(partner), grid.colOf(partner)}});
+            }
+        }
+    }
+    return result;
+}
+
+void Board::addPairsAround(int index)
+{
+    // 新出现的连接一定经过 index，并且至少有一端从 index 出发最多转一次弯就能看到：
+    // index 在第一段或最后一段上时，对应的一端沿直线就能看到 index；在中间一段上时，两端都是从这一段上的拐点横向看到的
+    // 所以只需要检查四个方向射线的尽头，以及射线经过的每个空格向两侧看到的第一个方块
+    const int *offsets = grid.neighbourOffsets();
+    for (int direction = 0; direction < 4; ++direction) {
+        int step = offsets[direction];
+        int side = direction < 2 ? RayTable::Up : RayTable::Left;
+        int end = rays.stop(index, direction);
+        for (int cell = index + step; cell != end; cell += step) {
+            for (int k = 0; k < 2; ++k) {
+                int block = rays.stop(cell, side + k);
+                if (grid.isBlock(block)) {
+                    affectedBlocks.insert(block);
+                }
+            }
+        }
+        if (grid.isBlock(end)) {
+            affectedBlocks.insert(end);
+        }
+    }
+
+    for (int block : affectedBlocks) {
+        for (int other : typeCells[grid.code(block) - CellGrid::CODE_BLOCK]) {
+            if (other != block && !pairIndex.hasPair(block, other) && rays.canLink(grid, block, other)) {
+                pairIndex.addPair(block, other);
+            }
+        }
+    }
+    affectedBlocks.clear();
+}
+
+int Board::countLinkablePairs() const
+{
+    return linkablePairs().pairCount();
+}
+
+bool Board::findHintPair(Point *first, Point *second) const
+{
+    int a, b;
+    if (!linkablePairs().firstPair(&a, &b)) {
+        return false;
+    }
+    *first = {grid.rowOf(a), grid.colOf(a)};
+    *second = {grid.rowOf(b), grid.colOf(b)};
+    // 顺便把路线放进缓存，玩家照着提示消除时不用再搜索
+    connect(first->row, first->col, second->row, second->col);
+    return true;
+}
+
+bool Board::matchPair(int player, int row1, int col1, int row2, int col2, std::vector<Point> *path)
+{
+    // 按当前规则检查能否连接，路线直接写进 path
+    if (!connect(row1, col1, row2, col2, path)) {
+        return false;
+    }
+
+    removePair(row1, col1, row2, col2);
+    addScore(player, PAIR_SCORE);
+    return true;
+}
+
+void Board::removePair(int row1, int col1, int row2, int col2)
+{
+    int type = cell(row1, col1);
+    bool tracked = patternMutations == mutations && patternDeadlock == Deadlock::None &&
+                   type >= 0 && type == cell(row2, col2);
+    writeCell(grid.index(row1, col1), CellGrid::CODE_EMPTY);
+    writeCell(grid.index(row2, col2), CellGrid::CODE_EMPTY);
+    // 消掉一对只改变这一种方块的数量和位置，别的种类原来不是死局形状，现在也不会是
+    if (tracked) {
+        patternDeadlock = deadlockOfType(type);
+        patternMutations = mutations;
+    }
+}
+
+void Board::deriveLinkablePairs(const PairIndex &before, int row1, int col1, int row2, int col2)
+{
+    if (pairIndexValid || !isDefaultRule()) {
+        return;
+    }
+    int first = grid.index(row1, col1);
+    int second = grid.index(row2, col2);
+    pairIndex = before;
+    pairIndex.removeCell(first);
+    pairIndex.removeCell(second);
+    // 新出现的连接至少经过两个腾出的格子之一，在两格都腾空之后补充即可
+    addPairsAround(first);
+    addPairsAround(second);
+    pairIndexValid = true;
+}
+
+int Board::score(int player) const
+{
+    return player == 1 ? player1Score : player2Score;
+}
+
+void Board::setScore(int player, int score)
+{
+    pending.scores = true;
+    if (player == 1) {
+        player1Score = score;
+    } else {
+        player2Score = score;
+    }
+}
+
+void Board::addScore(int player, int points)
+{
+    pending.scores = true;
+    if (player == 1) {
+        player1Score += points;
+    } else {
+        player2Score += points;
+    }
+}
+
+bool Board::tick()
+{
+    if (timeLeft <= 0) {
+        return false;
+    }
+    timeLeft--;
+    pending.timer = true;
+    return true;
+}
+
+void Board::setRemainingTime(int seconds)
+{
+    timeLeft = seconds;
+    pending.timer = true;
+}
+
+void Board::addTime(int seconds)
+{
+    timeLeft += seconds;
+    pending.timer = true;
+}
+
+void Board::setPlayerPosition(int player, int row, int col)
+{
+    Point &position = (player == 1) ? player1Position : player2Position;
+    // 玩家所在的格子会高亮显示，所以新旧两个格子都要重绘
+    if (contains(position.row, position.col)) {
+        markCell(grid.index(position.row, position.col));
+    }
+    position = {row, col};
+    if (contains(row, col)) {
+        markCell(grid.index(row, col));
+    }
+    pending.players = true;
+}
+
+bool Board::isGameFinished() const
+{
+    return numBlocks == 0;  // 没有剩下非空白、非道具的方块
+}
+
+bool Board::allBlocksCleared() const
+{
+    return isGameFinished();
+}
+
+bool Board::hasMatchingPairs() const
+{
+    return linkablePairs().pairCount() > 0;
+}
@@ -0,0 +1,274 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include "bitboard.h"
+#include "cellgrid.h"
+#include "disjointsets.h"
+#include "linkfinder.h"
+#include "pairindex.h"
+#include "raytable.h"
+#include "sparsecellset.h"
+#include <array>
+#include <random>
+#include <utility>
+#include <vector>
+
+// 连连看规则引擎：地图、道具、寻路、计分与结束条件
+// 不依赖 Qt，可以在没有界面的环境中运行（批量模拟、基准测试、服务器）
+class Board
+{
+public:
+    enum class PropType {
+        None,
+        PlusOneSecond,
+        Shuffle,
+        Hint,
+        Flash,  // 仅在单人模式中使用
+        Freeze, // 仅在双人模式中使用
+        Dizzy   // 仅在双人模式中使用
+    };
+    struct Prop {
+        PropType type;
+        int row;
+        int col;
+    };
+    struct Point {
+        int row;
+        int col;
+    };
+    // 自上次取走以来发生的变化，界面只需要重绘这些部分
+    struct ChangeSet {
+        std::vector<Point> cells;  // 内容变化的格子（已去重）
+        bool layout = false;       // 整张地图被替换（生成、改变大小），需要全部重绘
+        bool players = false;
+        bool scores = false;
+        bool timer = false;
+        bool empty() const { return cells.empty() && !layout && !players && !scores && !timer; }
+    };
+
+    static constexpr int EMPTY = -1;  // 空地
+    static constexpr int PROP = -2;   // 道具
+    static constexpr int BLOCK_TYPES = 3;  // 方块种类数
+    static constexpr int MAX_BLOCK_TYPES = BitBoard::MAX_TYPES;  // 存档中允许的方块种类上限
+    static constexpr int MAX_SIZE = BitBoard::MAX_DIM - 2;  // 行数和列数的上限（一行要放进一个 64 位掩码）
+    static constexpr int GRID_SIZE = 14;  // 默认网格大小（行数和列数）
+    static constexpr int GAME_DURATION = 300; // 游戏时长（秒）
+    static constexpr int PROP_PERCENT = 10;  // 道具占内部格子的百分比
+    static constexpr int MAX_PROP_PERCENT = 35;
+    static constexpr int PROP_PERCENT_STEP = 3;  // 按难度生成时每次重试调整的道具比例
+    static constexpr int GENERATE_CANDIDATES = 8;  // 按难度生成时最多评分的地图数
+    static constexpr int RATING_PLAYOUTS = 48;  // 每张地图的模拟对局数
+    static constexpr int PAIR_SCORE = 2;  // 每消除一对方块的得分
+    static constexpr int MAX_TURNS = 3;  // 限制转折次数时允许的最大值
+    static constexpr int UNLIMITED_TURNS = -1;  // 不限转折次数，取最短路线
+    static constexpr int MAX_ROUTE_POINTS = MAX_TURNS + 2;  // 限制转折次数时路线最多的点数
+
+    // 连接规则：允许的转折次数（0~MAX_TURNS 或 UNLIMITED_TURNS），以及路线能否经过地图外的一圈
+    struct LinkRule {
+        int maxTurns = 2;
+        bool allowOutside = false;
+    };
+
+    // 打乱剩余方块时的保证：Any 只打乱；Playable 保证至少有一对能消除；Solvable 保证整局能消完
+    // 耗时都有上界：Solvable 先倒着放回成对方块，放不满时再打乱几次交给求解器确认，仍做不到时退而保证 Playable
+    enum class ShuffleMode {
+        Any,
+        Playable,
+        Solvable
+    };
+
+    // 死局：可能还有能消除的对，但按当前规则已经不可能把方块全部消完
+    enum class Deadlock {
+        None,
+        OddCount,     // 某种方块剩奇数个
+        Crossed,      // 两种方块各剩两个，在 2x2 里交叉摆放；最多两个转折时谁也连不上
+        Interleaved,  // 不允许转折时两种方块各剩两个，在同一行（列）上交错摆放
+        Stranded,     // 不允许转折时某个方块所在的行和列上都没有同类方块
+        Proven        // 不是上面几种形状，由求解器证明无解
+    };
+
+    // 生成地图的目标难度，由 DifficultyRater 用模拟对局评分
+    enum class Difficulty {
+        Easy,
+        Normal,
+        Hard
+    };
+
+    // 连接路线：起点、拐点和终点，不能连接时为空；允许绕到地图外时点的坐标可以是 -1 或 rows/cols
+    using Route = std::vector<Point>;
+
+    explicit Board(bool isTwoPlayerMode = false);
+
+    void seed(unsigned int value);
+    bool isTwoPlayerMode() const { return twoPlayerMode; }
+    void setTwoPlayerMode(bool enabled) { twoPlayerMode = enabled; }
+    const LinkRule &linkRule() const { return rule; }
+    void setLinkRule(const LinkRule &value);
+    static bool isValidLinkRule(const LinkRule &value);
+
+    // 地图
+    int rows() const { return grid.rows(); }
+    int cols() const { return grid.cols(); }
+    bool contains(int row, int col) const;
+    void resize(int rows, int cols);
+    int cell(int row, int col) const { return grid.value(row, col); }
+    void setCell(int row, int col, int value);
+    const CellGrid &cells() const { return grid; }
+    const BitBoard &bitBoard() const { return bits; }
+    void generateMap();  // 按倒序放置成对方块，生成的地图一定能消完
+    // 评分落在该难度的区间内时返回 true，否则留下最接近的一张；threads 是评分用的线程数，0 表示每个核心一个
+    bool generateMap(Difficulty difficulty, int threads = 0);
+    bool shuffleBlocks(ShuffleMode mode = ShuffleMode::Any);  // 返回是否做到了 mode 要求的保证
+    int countBlockType(int type) const { return typeCells[type].size(); }
+    const SparseCellSet &blocksOfType(int type) const { return typeCells[type]; }
+    bool isMapSolvable() const;  // 默认预算内没有证明无解就返回 true，需要区分“不确定”时直接用 Solver
+    // 先查常见的死局形状（消除一对后只重查这一种方块），没有发现时再用求解器在 maxMilliseconds 内确认，0 表示不用求解器
+    Deadlock findDeadlock(int maxMilliseconds = 0) const;
+
+    // 计数器：随每次修改同步更新，读取都是 O(1)
+    int blockCount() const { return numBlocks; }
+    int emptyCount() const { return emptyCells.size(); }
+    int propCount() const { return numProps; }
+    bool verifyCounters() const;  // 重新数一遍地图，检查计数器和分类是否一致
+
+    // 道具（类型按格子存放，查找、放置和拾取都是 O(1)）
+    template <typename F> void forEachProp(F f) const;
+    PropType propAt(int row, int col) const;
+    void addProp(PropType type, int row, int col);
+    PropType takeProp(int row, int col);
+    void clearProps();
+    std::vector<PropType> availableProps() const;
+    PropType randomPropType();
+    bool spawnProp(PropType type, Point *spot);  // 没有空地时返回 false
+
+    // 寻路
+    bool isEmptyOrBorder(int row, int col) const;
+    bool checkStraightLine(int row1, int col1, int row2, int col2) const;
+    // 按当前连接规则，一次搜索同时给出能否连接和最优路线；结果按 (格子对, 修改序号) 缓存，同一步里的计分、绘制和提示共用
+    // 限制转折时最优指转折最少、其次最短，不限转折时指最短、其次转折最少；同一局面下两个方向得到同一条路线
+    bool connect(int row1, int col1, int row2, int col2, Route *route = nullptr) const;
+    unsigned int mutationCount() const { return mutations; }
+    bool canConnect(int row1, int col1, int row2, int col2) const;
+    std::vector<Point> findPath(int row1, int col1, int row2, int col2) const;
+    bool canReachPosition(int startRow, int startCol, int endRow, int endCol) const;  // 只经过空地能否走到
+    // 闪现的落点：点击空地时就是该空地，点击方块时是方块四周能走到的空地；都走不到时返回 false
+    bool findFlashDestination(int startRow, int startCol, int row, int col, Point *destination) const;
+    int countLinkablePairs() const;  // 当前可以消除的方块对数，即玩家可以选择的步数
+    bool findHintPair(Point *first, Point *second) const;
+    const PairIndex &linkablePairs() const;
+    std::vector<std::pair<Point, Point>> findAllLinkablePairs() const;  // 一次取出所有可以消除的方块对
+
+    // 消除、计分与结束条件
+    bool matchPair(int player, int row1, int col1, int row2, int col2, std::vector<Point> *path = nullptr);
+    void removePair(int row1, int col1, int row2, int col2);
+    // 回溯搜索用：before 是消除 (row1, col1)、(row2, col2) 这一对之前的 linkablePairs()，
+    // 从它增量得到当前的索引，代替整张重建；索引已经有效或者不是默认规则时什么都不做
+    void deriveLinkablePairs(const PairIndex &before, int row1, int col1, int row2, int col2);
+    int score(int player) const;
+    void setScore(int player, int score);
+    void addScore(int player, int points);
+    int remainingTime() const { return timeLeft; }
+    void setRemainingTime(int seconds);
+    void addTime(int seconds);
+    bool tick();
+    bool isGameFinished() const;
+    bool allBlocksCleared() const;
+    bool hasMatchingPairs() const;  // 是否存在真正可以连接的一对方块
+
+    // 玩家位置
+    Point playerPosition(int player) const { return player == 1 ? player1Position : player2Position; }
+    void setPlayerPosition(int player, int row, int col);
+
+    // 变化记录
+    const ChangeSet &changes() const { return pending; }
+    ChangeSet takeChanges();
+
+private:
+    int randomInt(int bound);
+    void writeCell(int index, uint8_t code);
+    void rebuildTypeCells();
+    void buildMap(int propPercent);
+    void finishMap();
+    int placePairsInReverse(SparseCellSet *freeCells, const std::vector<uint8_t> &codes, std::vector<int> *leftover);
+    bool arrangePlayable(const std::vector<int> &cells, std::vector<uint8_t> *codes);
+    bool arrangeSolvable(const std::vector<int> &cells, std::vector<uint8_t> *codes);
+    void writeBlockCodes(const std::vector<int> &cells, const std::vector<uint8_t> &codes);
+    void collectLinkableCells(int first, const SparseCellSet &freeCells, std::vector<int> *candidates) const;
+    Deadlock deadlockOfType(int type) const;
+    bool sameTypePairBetween(int first, int second) const;
+    void recount();
+    void markCell(int index);
+    void addPairsAround(int index);
+    bool reachable(int start, int target) const;
+    bool isDefaultRule() const { return rule.maxTurns == 2 && !rule.allowOutside; }
+    const CellGrid &routingGrid() const;
+    bool searchRoute(int from, int to, Route *route) const;
+    void rebuildPairIndex() const;
+
+    bool twoPlayerMode;
+    LinkRule rule;
+    CellGrid grid;
+    BitBoard bits;  // 与 grid 同步维护
+    RayTable rays;  // 与 grid 同步维护，只在格子由空变满或由满变空时更新
+    mutable LinkFinder finder;  // 寻路用的临时数组，在查询之间复用
+    mutable CellGrid outerGrid;  // 允许绕到地图外时寻路用的网格，比 grid 大一圈
+    mutable unsigned int outerGridMutations;  // outerGrid 对应的修改序号
+    mutable std::vector<int> cornerBuffer;  // 不限转折时的拐点下标
+    std::array<SparseCellSet, MAX_BLOCK_TYPES> typeCells;  // 每种方块当前所在的格子，与 grid 同步维护
+    std::vector<uint8_t> propTypes;  // 与 grid 下标对应，只有道具格子有意义
+    SparseCellSet emptyCells;  // 所有空地，用于 O(1) 随机选取
+    int numBlocks;
+    int numProps;
+    int player1Score;
+    int player2Score;
+    int timeLeft;
+    Point player1Position;
+    Point player2Position;
+    ChangeSet pending;
+
+    struct RouteCacheEntry {
+        unsigned int mutations;
+        int from;
+        int to;
+        Route route;
+    };
+    static constexpr int ROUTE_CACHE_SIZE = 8;
+    static constexpr int SHUFFLE_ATTEMPTS = 4;  // Solvable 打乱时交给求解器确认的次数
+    static constexpr long long SHUFFLE_SOLVER_NODES = 2000;  // 每次确认的节点预算
+    static constexpr int SHUFFLE_SOLVER_MILLISECONDS = 20;    // 每次确认的时间预算
+    unsigned int mutations;  // 每次修改地图都加一，缓存的路线只在相同的序号下有效
+    mutable std::array<RouteCacheEntry, ROUTE_CACHE_SIZE> routeCache;
+    mutable int routeCacheNext;
+    std::vector<uint8_t> changedMark;  // 与 grid 下标对应，用于给 pending.cells 去重
+
+    // 可消除的方块对：腾出格子时增量补充，其它可能让连接断开的修改（放置方块、打乱、读档）之后在下次查询时整体重建
+    mutable PairIndex pairIndex;
+    mutable bool pairIndexValid;
+    SparseCellSet affectedBlocks;  // addPairsAround 的临时集合
+
+    // 空地的连通分量：腾出格子时与相邻空地合并，空地被占用后在下次查询时整体重建
+    mutable DisjointSets emptySets;
+    mutable bool emptySetsValid;
+
+    // 死局检测的结果，只在相同的修改序号下有效；求解器的结论单独缓存，同一局面只跑一次
+    mutable Deadlock patternDeadlock;
+    mutable unsigned int patternMutations;
+    mutable bool solverDeadlock;
+    mutable unsigned int solverMutations;
+    std::mt19937 rng;
+};
+
+// 按行优先顺序遍历所有道具
+template <typename F>
+void Board::forEachProp(F f) const
+{
+    int seen = 0;
+    for (int i = 0; i < grid.size() && seen < numProps; ++i) {
+        if (grid.code(i) == CellGrid::CODE_PROP) {
+            f(Prop{static_cast<PropType>(propTypes[i]), grid.rowOf(i), grid.colOf(i)});
+            ++seen;
+        }
+    }
+}
+
+#endif // BOARD_H
@@ -0,0 +1,75 @@
+#include "cellgrid.h"
+#include <cstring>
+
+CellGrid::CellGrid()
+    : numRows(0), numCols(0), gridStride(2), offsets{-1, 1, -2, 2}
+{
+}
+
+CellGrid::CellGrid(int rows, int cols)
+    : CellGrid()
+{
+    reset(rows, cols);
+}
+
+void CellGrid::reset(int rows, int cols)
+{
+    numRows = rows;
+    numCols = cols;
+    gridStride = cols + 2;
+    offsets[0] = -1;
+    offsets[1] = 1;
+    offsets[2] = -gridStride;
+    offsets[3] = gridStride;
+
+    // 先全部填成哨兵，再把地图内部清空
+    cells.assign((rows + 2) * gridStride, CODE_WALL);
+    for (int row = 0; row < rows; ++row) {
+        std::memset(cells.data() + index(row, 0), CODE_EMPTY, cols);
+    }
+}
+
+void CellGrid::copyFrom(const CellGrid &other)
+{
+    if (cells.size() != other.cells.size()) {
+        *this = other;
+        return;
+    }
+    numRows = other.numRows;
+    numCols = other.numCols;
+    gridStride = other.gridStride;
+    std::memcpy(offsets, other.offsets, sizeof(offsets));
+    std::memcpy(cells.data(), other.cells.data(), cells.size());
+}
+
+void CellGrid::surround(const CellGrid &inner)
+{
+    if (numRows != inner.rows() + 2 || numCols != inner.cols() + 2) {
+        reset(inner.rows() + 2, inner.cols() + 2);
+    }
+    for (int row = 0; row < inner.rows(); ++row) {
+        std::memcpy(cells.data() + index(row + 1, 1), inner.data() + inner.index(row, 0), inner.cols());
+    }
+}
+
+uint8_t CellGrid::encode(int value)
+{
+    if (value == -1) {
+        return CODE_EMPTY;
+    }
+    if (value == -2) {
+        return CODE_PROP;
+    }
+    return static_cast<uint8_t>(CODE_BLOCK + value);
+}
+
+int CellGrid::decode(uint8_t code)
+{
+    if (code == CODE_EMPTY) {
+        return -1;
+    }
+    if (code == CODE_PROP) {
+        return -2;
+    }
+    return code - CODE_BLOCK;
+}
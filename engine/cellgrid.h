@@ -0,0 +1,58 @@
+#ifndef CELLGRID_H
+#define CELLGRID_H
+
+#include <cstdint>
+#include <vector>
+
+// 连续存储的格子数组（行优先），每个格子一个字节的编码
+// 外面额外包了一圈 WALL 哨兵格子，遍历时用固定的步长偏移访问邻居，不需要做边界检查
+class CellGrid
+{
+public:
+    static constexpr uint8_t CODE_EMPTY = 0;   // 空地
+    static constexpr uint8_t CODE_PROP = 1;    // 道具
+    static constexpr uint8_t CODE_BLOCK = 2;   // 方块类型 t 的编码为 CODE_BLOCK + t
+    static constexpr uint8_t CODE_WALL = 0xFF; // 地图外的哨兵
+
+    CellGrid();
+    CellGrid(int rows, int cols);
+
+    void reset(int rows, int cols);
+    void copyFrom(const CellGrid &other);
+    void surround(const CellGrid &inner);  // 变成 inner 外面再加一圈空地（允许路线绕到地图外时寻路用）
+
+    int rows() const { return numRows; }
+    int cols() const { return numCols; }
+    int stride() const { return gridStride; }
+    int size() const { return static_cast<int>(cells.size()); }
+
+    // 逻辑坐标 (row, col) 与带哨兵的线性下标之间的换算，row/col 可以取 -1 和 rows/cols
+    int index(int row, int col) const { return (row + 1) * gridStride + col + 1; }
+    int rowOf(int index) const { return index / gridStride - 1; }
+    int colOf(int index) const { return index % gridStride - 1; }
+
+    // 依次为左、右、上、下四个邻居的下标偏移
+    const int *neighbourOffsets() const { return offsets; }
+
+    uint8_t code(int index) const { return cells[index]; }
+    void setCode(int index, uint8_t code) { cells[index] = code; }
+    bool isEmpty(int index) const { return cells[index] == CODE_EMPTY; }
+    bool isBlock(int index) const { return cells[index] >= CODE_BLOCK && cells[index] != CODE_WALL; }
+    const uint8_t *data() const { return cells.data(); }
+
+    int value(int row, int col) const { return decode(cells[index(row, col)]); }
+    void setValue(int row, int col, int value) { cells[index(row, col)] = encode(value); }
+
+    // 编码与 Board 使用的取值（-1 空地，-2 道具，>= 0 方块类型）互相转换
+    static uint8_t encode(int value);
+    static int decode(uint8_t code);
+
+private:
+    int numRows;
+    int numCols;
+    int gridStride;
+    int offsets[4];
+    std::vector<uint8_t> cells;
+};
+
+#endif // CELLGRID_H
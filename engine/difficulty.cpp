@@ -0,0 +1,132 @@
+#include "difficulty.h"
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+namespace {
+
+uint64_t mix(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// 分数中三项的权重；卡住时通常只剩最后几对，剩余比例乘上 DEPTH_SCALE 后再封顶
+constexpr double FAIL_WEIGHT = 0.6;
+constexpr double DEPTH_WEIGHT = 0.2;
+constexpr double CHOICE_WEIGHT = 0.2;
+constexpr double DEPTH_SCALE = 10;
+
+}
+
+DifficultyRater::Band DifficultyRater::band(Board::Difficulty difficulty)
+{
+    switch (difficulty) {
+    case Board::Difficulty::Easy:
+        return {0, 0.05};
+    case Board::Difficulty::Normal:
+        return {0.05, 0.2};
+    case Board::Difficulty::Hard:
+        return {0.2, 1};
+    }
+    return {0, 1};
+}
+
+DifficultyRater::Rating DifficultyRater::rate(const Board &board, const Limits &limits)
+{
+    Rating rating;
+    int playouts = std::max(1, limits.playouts);
+    outcomes.assign(playouts, Outcome{});
+    nextPlayout.store(0);
+
+    int threads = limits.threads > 0 ? limits.threads : static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(1, std::min(threads, playouts));
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; ++i) {
+        workers.emplace_back(&DifficultyRater::runWorker, this, std::cref(board), std::cref(limits));
+    }
+    runWorker(board, limits);
+    for (std::thread &thread : workers) {
+        thread.join();
+    }
+
+    int blocks = board.blockCount();
+    if (blocks == 0) {
+        return rating;
+    }
+    int cleared = 0;
+    double choice = 0;
+    long long steps = 0;
+    double depth = 0;
+    for (const Outcome &outcome : outcomes) {
+        cleared += outcome.cleared;
+        choice += outcome.choice;
+        steps += outcome.steps;
+        depth += static_cast<double>(outcome.blocksLeft) / blocks;
+    }
+    rating.clearRate = static_cast<double>(cleared) / playouts;
+    rating.averageChoice = steps > 0 ? choice / steps : 0;
+    rating.deadEndDepth = depth / playouts;
+
+    // 消不完的比例为主，卡住得有多早、每一步的选择有多少为辅
+    rating.score = FAIL_WEIGHT * (1 - rating.clearRate) +
+                   DEPTH_WEIGHT * std::min(1.0, DEPTH_SCALE * rating.deadEndDepth) +
+                   CHOICE_WEIGHT * (1 - rating.averageChoice);
+    return rating;
+}
+
+void DifficultyRater::runWorker(const Board &board, const Limits &limits)
+{
+    int count = static_cast<int>(outcomes.size());
+    for (int i = nextPlayout.fetch_add(1); i < count; i = nextPlayout.fetch_add(1)) {
+        outcomes[i] = playout(board, mix(limits.seed ^ mix(i)), i % 2 == 1);
+    }
+}
+
+DifficultyRater::Outcome DifficultyRater::playout(const Board &board, uint64_t seed, bool greedy) const
+{
+    Board work = board;
+    const CellGrid &grid = work.cells();
+    std::mt19937_64 rng(seed);
+    std::vector<std::pair<int, int>> moves;
+    Outcome outcome{false, 0, 0, 0};
+
+    while (work.blockCount() > 0) {
+        const PairIndex &pairs = work.linkablePairs();
+        if (pairs.pairCount() == 0) {
+            break;
+        }
+        // 贪心时只保留曼哈顿距离最近的那些对
+        moves.clear();
+        int nearest = grid.size();
+        for (int cell : pairs.linkableCells()) {
+            for (int partner : pairs.partnersOf(cell)) {
+                if (partner < cell) {
+                    continue;
+                }
+                if (greedy) {
+                    int distance = std::abs(grid.rowOf(cell) - grid.rowOf(partner)) +
+                                   std::abs(grid.colOf(cell) - grid.colOf(partner));
+                    if (distance > nearest) {
+                        continue;
+                    }
+                    if (distance < nearest) {
+                        nearest = distance;
+                        moves.clear();
+                    }
+                }
+                moves.push_back({cell, partner});
+            }
+        }
+        outcome.choice += std::min(1.0, 2.0 * pairs.pairCount() / work.blockCount());
+        ++outcome.steps;
+        std::pair<int, int> move = moves[std::uniform_int_distribution<std::size_t>(0, moves.size() - 1)(rng)];
+        work.removePair(grid.rowOf(move.first), grid.colOf(move.first), grid.rowOf(move.second), grid.colOf(move.second));
+    }
+    outcome.cleared = work.blockCount() == 0;
+    outcome.blocksLeft = work.blockCount();
+    return outcome;
+}
@@ -0,0 +1,52 @@
+#ifndef DIFFICULTY_H
+#define DIFFICULTY_H
+
+#include "board.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// 用大量模拟对局估计一张地图有多难：一半是随机走子，一半是贪心地先消最近的一对（像随手点的玩家）
+// 每局一直消到清空或者没有可消除的对为止；多局之间互不依赖，分给多个线程并行
+// 每局的随机数只由 seed 和局号决定，结果与线程数无关
+class DifficultyRater
+{
+public:
+    struct Limits {
+        int playouts = 64;
+        int threads = 0;  // 0 表示每个核心一个
+        uint64_t seed = 0;
+    };
+    struct Rating {
+        double clearRate = 1;     // 能消完的对局比例
+        double averageChoice = 1; // 平均每一步可选的对数与剩余对数之比（不超过 1）
+        double deadEndDepth = 0;  // 卡住时剩下的方块占开局方块的比例，按全部对局平均（消完的记 0）
+        double score = 0;         // 0~1，越大越难
+    };
+    // 各难度接受的分数区间 [low, high]
+    struct Band {
+        double low;
+        double high;
+        bool contains(double score) const { return score >= low && score <= high; }
+    };
+
+    static Band band(Board::Difficulty difficulty);
+
+    Rating rate(const Board &board, const Limits &limits);
+
+private:
+    struct Outcome {
+        bool cleared;
+        double choice;  // 各步可选对数与剩余对数之比（不超过 1）之和
+        int steps;
+        int blocksLeft;
+    };
+
+    void runWorker(const Board &board, const Limits &limits);
+    Outcome playout(const Board &board, uint64_t seed, bool greedy) const;
+
+    std::atomic<int> nextPlayout;
+    std::vector<Outcome> outcomes;
+};
+
+#endif // DIFFICULTY_H
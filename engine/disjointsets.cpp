@@ -0,0 +1,34 @@
+#include "disjointsets.h"
+#include <numeric>
+#include <utility>
+
+void DisjointSets::reset(int count)
+{
+    parent.resize(count);
+    std::iota(parent.begin(), parent.end(), 0);
+    setSize.assign(count, 1);
+}
+
+int DisjointSets::find(int element)
+{
+    while (parent[element] != element) {
+        parent[element] = parent[parent[element]];
+        element = parent[element];
+    }
+    return element;
+}
+
+bool DisjointSets::unite(int first, int second)
+{
+    first = find(first);
+    second = find(second);
+    if (first == second) {
+        return false;
+    }
+    if (setSize[first] < setSize[second]) {
+        std::swap(first, second);
+    }
+    parent[second] = first;
+    setSize[first] += setSize[second];
+    return true;
+}
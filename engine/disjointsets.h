@@ -0,0 +1,22 @@
+#ifndef DISJOINTSETS_H
+#define DISJOINTSETS_H
+
+#include <vector>
+
+// 并查集：按大小合并，查找时路径减半
+// 只支持合并，集合需要拆分时只能 reset 后重建
+class DisjointSets
+{
+public:
+    void reset(int count);
+
+    int find(int element);
+    bool unite(int first, int second);  // 已在同一集合时返回 false
+    bool same(int first, int second) { return find(first) == find(second); }
+
+private:
+    std::vector<int> parent;
+    std::vector<int> setSize;
+};
+
+#endif // DISJOINTSETS_H
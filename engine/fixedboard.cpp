@@ -0,0 +1,15 @@
+#include "fixedboard.h"
+
+namespace FixedKernels {
+
+bool canLink(const Board &board, int row1, int col1, int row2, int col2)
+{
+    if (board.rows() == Board::GRID_SIZE && board.cols() == Board::GRID_SIZE) {
+        FixedBoard<Board::GRID_SIZE, Board::GRID_SIZE> fixed;
+        fixed.load(board);
+        return fixed.canLink(fixed.index(row1, col1), fixed.index(row2, col2));
+    }
+    return board.bitBoard().canLink(row1, col1, row2, col2);
+}
+
+}
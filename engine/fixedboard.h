@@ -0,0 +1,161 @@
+#ifndef FIXEDBOARD_H
+#define FIXEDBOARD_H
+
+#include "board.h"
+#include <array>
+
+// 编译期确定尺寸的棋盘快照，寻路和配对扫描的循环次数都是常量，便于编译器展开和向量化
+// 下标布局与 CellGrid / BitBoard 相同（带一圈哨兵），只保存行、列的占用掩码
+template <int R, int C>
+class FixedBoard
+{
+public:
+    static_assert(R >= 1 && C >= 1 && R + 2 <= BitBoard::MAX_DIM && C + 2 <= BitBoard::MAX_DIM,
+                  "FixedBoard: unsupported size");
+
+    static constexpr int ROWS = R;
+    static constexpr int COLS = C;
+    static constexpr int STRIDE = C + 2;
+    static constexpr int CELLS = (R + 2) * (C + 2);
+
+    void load(const Board &board)
+    {
+        const BitBoard &bits = board.bitBoard();
+        for (int r = 0; r < R + 2; ++r) {
+            rowBits[r] = bits.rowMask(r - 1);
+        }
+        for (int c = 0; c < C + 2; ++c) {
+            colBits[c] = bits.colMask(c - 1);
+        }
+    }
+
+    int index(int row, int col) const { return (row + 1) * STRIDE + col + 1; }
+
+    // 两个格子（带哨兵的下标）能否用不超过两个转折的路线连接
+    bool canLink(int first, int second) const
+    {
+        if (first == second) {
+            return false;
+        }
+        return linkable(first, second, horizontalReach(first), horizontalReach(second),
+                        verticalReach(first), verticalReach(second));
+    }
+
+    // 枚举所有可以消除的方块对，只在同类方块之间枚举
+    template <typename F>
+    void forEachLinkablePair(const Board &board, F visit) const
+    {
+        for (int type = 0; type < Board::MAX_BLOCK_TYPES; ++type) {
+            const SparseCellSet &cells = board.blocksOfType(type);
+            prepareReach(cells);
+            for (int i = 0; i < cells.size(); ++i) {
+                for (int j = i + 1; j < cells.size(); ++j) {
+                    if (linkable(cells[i], cells[j])) {
+                        visit(cells[i], cells[j]);
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    uint64_t horizontalReach(int index) const
+    {
+        int r = index / STRIDE;
+        int c = index % STRIDE;
+        uint64_t bits = rowBits[r];
+        int left = highestBit(bits & ((uint64_t(1) << c) - 1));
+        int right = lowestBit(bits >> (c + 1)) + c + 1;
+        return bitsRange(left + 1, right - 1);
+    }
+
+    uint64_t verticalReach(int index) const
+    {
+        int r = index / STRIDE;
+        int c = index % STRIDE;
+        uint64_t bits = colBits[c];
+        int up = highestBit(bits & ((uint64_t(1) << r) - 1));
+        int down = lowestBit(bits >> (r + 1)) + r + 1;
+        return bitsRange(up + 1, down - 1);
+    }
+
+    void prepareReach(const SparseCellSet &blocks) const
+    {
+        for (int index : blocks) {
+            reachH[index] = horizontalReach(index);
+            reachV[index] = verticalReach(index);
+        }
+    }
+
+    bool linkable(int first, int second) const
+    {
+        return linkable(first, second, reachH[first], reachH[second], reachV[first], reachV[second]);
+    }
+
+    // 横-竖-横：两端的横向可达列相交，并且该列在两行之间没有障碍；竖-横-竖同理
+    // 两行之间的障碍用固定次数的循环按掩码合并，不依赖数据分支
+    bool linkable(int first, int second, uint64_t h1, uint64_t h2, uint64_t v1, uint64_t v2) const
+    {
+        int r1 = first / STRIDE;
+        int c1 = first % STRIDE;
+        int r2 = second / STRIDE;
+        int c2 = second % STRIDE;
+
+        uint64_t columns = h1 & h2;
+        if (columns) {
+            int low = r1 < r2 ? r1 : r2;
+            int high = r1 < r2 ? r2 : r1;
+            uint64_t blocked = 0;
+            for (int r = 0; r < R + 2; ++r) {
+                blocked |= rowBits[r] & (uint64_t(0) - uint64_t(r > low && r < high));
+            }
+            if (columns & ~blocked) {
+                return true;
+            }
+        }
+
+        uint64_t rows = v1 & v2;
+        if (rows) {
+            int low = c1 < c2 ? c1 : c2;
+            int high = c1 < c2 ? c2 : c1;
+            uint64_t blocked = 0;
+            for (int c = 0; c < C + 2; ++c) {
+                blocked |= colBits[c] & (uint64_t(0) - uint64_t(c > low && c < high));
+            }
+            if (rows & ~blocked) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::array<uint64_t, R + 2> rowBits;
+    std::array<uint64_t, C + 2> colBits;
+    mutable std::array<uint64_t, CELLS> reachH;
+    mutable std::array<uint64_t, CELLS> reachV;
+};
+
+// 默认的 14x14 棋盘使用编译期特化的内核，其余尺寸（例如存档中读入的尺寸）退回到按运行时尺寸计算的 BitBoard
+namespace FixedKernels {
+bool canLink(const Board &board, int row1, int col1, int row2, int col2);
+
+// 参数为带哨兵的下标；逐对检查只在默认尺寸下更快，棋盘变大后同类方块的对数按平方增长，
+// 改用 BitBoard::forEachLinkablePair 按方块展开可达范围批量计算
+template <typename F>
+void forEachLinkablePair(const Board &board, F visit)
+{
+    if (board.rows() == Board::GRID_SIZE && board.cols() == Board::GRID_SIZE) {
+        FixedBoard<Board::GRID_SIZE, Board::GRID_SIZE> fixed;
+        fixed.load(board);
+        fixed.forEachLinkablePair(board, visit);
+        return;
+    }
+
+    const CellGrid &grid = board.cells();
+    board.bitBoard().forEachLinkablePair([&](int row1, int col1, int row2, int col2) {
+        visit(grid.index(row1, col1), grid.index(row2, col2));
+    });
+}
+}
+
+#endif // FIXEDBOARD_H
@@ -0,0 +1,178 @@
+#include "linkfinder.h"
+#include <algorithm>
+
+LinkFinder::LinkFinder()
+    : epoch(0), nextSize(0), currentLayer(0), bestCost(-1), hitKey(-1)
+{
+}
+
+void LinkFinder::prepare(int cells)
+{
+    if (static_cast<int>(stamp.size()) < cells * 2) {
+        stamp.assign(cells * 2, 0);
+        parent.resize(cells * 2);
+        layer.resize(cells * 2);
+        cost.resize(cells * 2);
+        current.resize(cells * 2);
+        next.resize(cells * 2);
+        epoch = 0;
+    }
+    if (++epoch == 0) {
+        std::fill(stamp.begin(), stamp.end(), 0);
+        epoch = 1;
+    }
+    nextSize = 0;
+    currentLayer = 0;
+    bestCost = -1;
+    hitKey = -1;
+}
+
+void LinkFinder::reach(int key, int parentKey, int value)
+{
+    // 第一次到达时记入下一层；同一层内再次到达时只在代价更小时改写父指针
+    if (stamp[key] != epoch) {
+        stamp[key] = epoch;
+        layer[key] = currentLayer;
+        parent[key] = parentKey;
+        cost[key] = value;
+        next[nextSize++] = key;
+    } else if (layer[key] == currentLayer && value < cost[key]) {
+        parent[key] = parentKey;
+        cost[key] = value;
+    }
+}
+
+void LinkFinder::cast(const CellGrid &grid, int start, int startKey, int direction, int to)
+{
+    // 从 start 沿 direction 前进，直到遇到非空格子；经过的空地记入下一层
+    int step = grid.neighbourOffsets()[direction];
+    int axis = direction < 2 ? 0 : 1;
+    int length = startKey >= 0 ? cost[startKey] : 0;
+    for (int cell = start + step; ; cell += step) {
+        ++length;
+        if (cell == to) {
+            if (bestCost < 0 || length < bestCost) {
+                bestCost = length;
+                hitKey = startKey;
+            }
+            return;
+        }
+        if (!grid.isEmpty(cell)) {
+            return;
+        }
+        reach(cell * 2 + axis, startKey, length);
+    }
+}
+
+int LinkFinder::find(const CellGrid &grid, int from, int to, int maxTurns, int *corners)
+{
+    if (from == to) {
+        return 0;
+    }
+    prepare(grid.size());
+
+    for (int direction = 0; direction < 4; ++direction) {
+        cast(grid, from, -1, direction, to);
+    }
+
+    // 某一层到达终点后仍把这一层处理完，取其中最短的
+    for (int turns = 1; turns <= maxTurns && bestCost < 0 && nextSize > 0; ++turns) {
+        current.swap(next);
+        int size = nextSize;
+        nextSize = 0;
+        currentLayer = turns;
+        for (int i = 0; i < size; ++i) {
+            int key = current[i];
+            int cell = key >> 1;
+            // 水平到达的格子向上下转，垂直到达的格子向左右转
+            int first = (key & 1) ? 0 : 2;
+            cast(grid, cell, key, first, to);
+            cast(grid, cell, key, first + 1, to);
+        }
+    }
+
+    if (bestCost < 0) {
+        return 0;
+    }
+
+    // 沿父指针回溯各段起点，得到倒序的拐点
+    int count = 2;
+    for (int key = hitKey; key >= 0; key = parent[key]) {
+        ++count;
+    }
+    if (corners) {
+        int i = count - 1;
+        corners[i--] = to;
+        for (int key = hitKey; key >= 0; key = parent[key]) {
+            corners[i--] = key >> 1;
+        }
+        corners[0] = from;
+    }
+    return count;
+}
+
+int LinkFinder::shortest(const CellGrid &grid, int from, int to, std::vector<int> *corners)
+{
+    if (from == to) {
+        return 0;
+    }
+    prepare(grid.size());
+
+    // 第 L 层是走 L 步能到达的 (格子, 方向轴)，代价为转折次数
+    const int *offsets = grid.neighbourOffsets();
+    for (int direction = 0; direction < 4; ++direction) {
+        int cell = from + offsets[direction];
+        if (cell == to) {
+            bestCost = 0;
+        } else if (grid.isEmpty(cell)) {
+            reach(cell * 2 + (direction < 2 ? 0 : 1), -1, 0);
+        }
+    }
+    while (bestCost < 0 && nextSize > 0) {
+        current.swap(next);
+        int size = nextSize;
+        nextSize = 0;
+        ++currentLayer;
+        for (int i = 0; i < size; ++i) {
+            int key = current[i];
+            int cell = key >> 1;
+            for (int direction = 0; direction < 4; ++direction) {
+                int axis = direction < 2 ? 0 : 1;
+                int nextCell = cell + offsets[direction];
+                int turns = cost[key] + (axis != (key & 1));
+                if (nextCell == to) {
+                    if (bestCost < 0 || turns < bestCost) {
+                        bestCost = turns;
+                        hitKey = key;
+                    }
+                } else if (grid.isEmpty(nextCell)) {
+                    reach(nextCell * 2 + axis, key, turns);
+                }
+            }
+        }
+    }
+    if (bestCost < 0) {
+        return 0;
+    }
+
+    // 从终点回溯，只保留方向改变的格子
+    corners->clear();
+    corners->push_back(to);
+    int previousAxis = -1;
+    for (int key = hitKey; key >= 0; key = parent[key]) {
+        int cell = key >> 1;
+        int axis = key & 1;
+        int nextCell = corners->back();
+        // 到达终点的那一步的方向轴
+        if (previousAxis < 0) {
+            previousAxis = (nextCell - cell == 1 || cell - nextCell == 1) ? 0 : 1;
+        }
+        if (axis != previousAxis) {
+            corners->push_back(cell);
+        }
+        previousAxis = axis;
+    }
+    corners->push_back(from);
+    std::reverse(corners->begin(), corners->end());
+    return static_cast<int>(corners->size());
+}
@@ -0,0 +1,47 @@
+#ifndef LINKFINDER_H
+#define LINKFINDER_H
+
+#include "cellgrid.h"
+#include <cstdint>
+#include <vector>
+
+// 按直线段搜索、限制转折次数的寻路器
+// 第 t 层是转折 t 次能到达的所有 (格子, 方向轴)，每层从上一层的格子向两个垂直方向发射射线
+// 同一层内多次到达同一状态时保留更短的那条，因此第一次到达终点的那一层结束后得到的就是
+// 转折最少、其次最短的路线；长度相同时取搜索顺序中先出现的，结果只取决于棋盘和两个端点
+// 访问标记用查询序号（epoch）区分，父指针只记录每段的起点；临时数组只在棋盘变大时重新分配，
+// 单次查询不做堆分配
+class LinkFinder
+{
+public:
+    LinkFinder();
+
+    // 找一条从 from 到 to、转折不超过 maxTurns 次的最优路线（下标为 CellGrid 中带哨兵的下标）
+    // 中间只能经过空地；corners 依次写入起点、拐点和终点，需要 maxTurns + 2 个位置，可以为 nullptr
+    // 返回写入的点数，不能连接时返回 0
+    int find(const CellGrid &grid, int from, int to, int maxTurns, int *corners);
+    bool connected(const CellGrid &grid, int from, int to, int maxTurns) { return find(grid, from, to, maxTurns, nullptr) > 0; }
+
+    // 不限转折次数时的最短路线（按经过的格子数），长度相同时转折最少；逐格按长度分层做广度优先搜索
+    // corners 的内容被替换为起点、拐点和终点，返回点数，不能连接时返回 0
+    int shortest(const CellGrid &grid, int from, int to, std::vector<int> *corners);
+
+private:
+    void prepare(int cells);
+    void cast(const CellGrid &grid, int start, int startKey, int direction, int to);
+    void reach(int key, int parentKey, int cost);
+
+    uint32_t epoch;
+    std::vector<uint32_t> stamp;  // 下标为 格子 * 2 + 方向轴（0 水平，1 垂直）
+    std::vector<int> parent;      // find：该段起点的键；shortest：上一个格子的键；-1 表示出发格子
+    std::vector<int> layer;       // 第一次到达该状态时所在的层
+    std::vector<int> cost;        // find 中为长度，shortest 中为转折次数；只在同一层内比较
+    std::vector<int> current;     // 当前层
+    std::vector<int> next;        // 下一层
+    int nextSize;
+    int currentLayer;
+    int bestCost;                 // 到达终点的最小代价，没有到达时为 -1
+    int hitKey;                   // 到达终点之前的最后一个状态
+};
+
+#endif // LINKFINDER_H
@@ -0,0 +1,71 @@
+#include "pairindex.h"
+#include <algorithm>
+
+PairIndex::PairIndex()
+    : numPairs(0)
+{
+}
+
+void PairIndex::reset(int cells)
+{
+    partners.assign(cells, std::vector<int>());
+    linkable.reset(cells);
+    numPairs = 0;
+}
+
+void PairIndex::clear()
+{
+    for (int index : linkable) {
+        partners[index].clear();
+    }
+    linkable.clear();
+    numPairs = 0;
+}
+
+void PairIndex::addPair(int first, int second)
+{
+    partners[first].push_back(second);
+    partners[second].push_back(first);
+    linkable.insert(first);
+    linkable.insert(second);
+    ++numPairs;
+}
+
+void PairIndex::unlink(int index, int partner)
+{
+    std::vector<int> &list = partners[index];
+    auto it = std::find(list.begin(), list.end(), partner);
+    if (it != list.end()) {
+        *it = list.back();
+        list.pop_back();
+    }
+    if (list.empty()) {
+        linkable.erase(index);
+    }
+}
+
+void PairIndex::removeCell(int index)
+{
+    for (int partner : partners[index]) {
+        unlink(partner, index);
+        --numPairs;
+    }
+    partners[index].clear();
+    linkable.erase(index);
+}
+
+bool PairIndex::hasPair(int first, int second) const
+{
+    const std::vector<int> &list = partners[first];
+    return std::find(list.begin(), list.end(), second) != list.end();
+}
+
+bool PairIndex::firstPair(int *first, int *second) const
+{
+    if (linkable.empty()) {
+        return false;
+    }
+    *first = linkable[0];
+    *second = partners[*first][0];
+    return true;
+}
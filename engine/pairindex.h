@@ -0,0 +1,35 @@
+#ifndef PAIRINDEX_H
+#define PAIRINDEX_H
+
+#include "sparsecellset.h"
+#include <vector>
+
+// 当前所有可以消除的方块对
+// 每个方块记录能和它连接的同类方块，另外用稀疏集合记录至少有一个搭档的方块，
+// 因此“还有没有可消除的对”“给出一对提示”“一共有几对”都是 O(1)
+class PairIndex
+{
+public:
+    PairIndex();
+
+    void reset(int cells);
+    void clear();
+
+    void addPair(int first, int second);
+    void removeCell(int index);  // 删除与该格子有关的所有对
+    bool hasPair(int first, int second) const;
+
+    int pairCount() const { return numPairs; }
+    const SparseCellSet &linkableCells() const { return linkable; }
+    const std::vector<int> &partnersOf(int index) const { return partners[index]; }
+    bool firstPair(int *first, int *second) const;
+
+private:
+    void unlink(int index, int partner);
+
+    std::vector<std::vector<int>> partners;
+    SparseCellSet linkable;  // 至少有一个搭档的格子
+    int numPairs;
+};
+
+#endif // PAIRINDEX_H
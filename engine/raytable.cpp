@@ -0,0 +1,163 @@
+#include "raytable.h"
+#include <algorithm>
+#include <cstdlib>
+
+void RayTable::reset(const CellGrid &grid)
+{
+    int stride = grid.stride();
+    int height = grid.rows() + 2;
+    stops.assign(grid.size() * 4, -1);
+
+    // 逐行、逐列各扫一遍，记下每个方向上最近的被占用格子
+    for (int row = 0; row < height; ++row) {
+        int first = row * stride;
+        int last = first + stride - 1;
+        int blocker = -1;
+        for (int i = first; i <= last; ++i) {
+            stops[i * 4 + Left] = blocker;
+            if (!grid.isEmpty(i)) {
+                blocker = i;
+            }
+        }
+        blocker = -1;
+        for (int i = last; i >= first; --i) {
+            stops[i * 4 + Right] = blocker;
+            if (!grid.isEmpty(i)) {
+                blocker = i;
+            }
+        }
+    }
+    for (int col = 0; col < stride; ++col) {
+        int first = col;
+        int last = (height - 1) * stride + col;
+        int blocker = -1;
+        for (int i = first; i <= last; i += stride) {
+            stops[i * 4 + Up] = blocker;
+            if (!grid.isEmpty(i)) {
+                blocker = i;
+            }
+        }
+        blocker = -1;
+        for (int i = last; i >= first; i -= stride) {
+            stops[i * 4 + Down] = blocker;
+            if (!grid.isEmpty(i)) {
+                blocker = i;
+            }
+        }
+    }
+}
+
+void RayTable::fill(int from, int to, int step, int direction, int value)
+{
+    for (int i = from; i != to + step; i += step) {
+        stops[i * 4 + direction] = value;
+    }
+}
+
+void RayTable::update(const CellGrid &grid, int index)
+{
+    // index 左右两侧最近的障碍之间的格子，它们朝向 index 的射线会改变（两端的障碍本身也包括在内）
+    // index 变为占用时射线停在 index，变为空地时射线穿过 index 停在另一侧的障碍
+    bool occupied = !grid.isEmpty(index);
+    int stride = grid.stride();
+
+    int left = stop(index, Left);
+    int right = stop(index, Right);
+    fill(index + 1, right, 1, Left, occupied ? index : left);
+    fill(left, index - 1, 1, Right, occupied ? index : right);
+
+    int up = stop(index, Up);
+    int down = stop(index, Down);
+    fill(index + stride, down, stride, Up, occupied ? index : up);
+    fill(up, index - stride, stride, Down, occupied ? index : down);
+}
+
+bool RayTable::segmentClear(const CellGrid &grid, int from, int to) const
+{
+    if (from > to) {
+        std::swap(from, to);
+    }
+    if (to - from < grid.stride()) {
+        return stop(from, Right) >= to;  // 同一行
+    }
+    return stop(from, Down) >= to;  // 同一列
+}
+
+bool RayTable::canLink(const CellGrid &grid, int from, int to) const
+{
+    int first, second;
+    return from != to && middleSegment(grid, from, to, false, &first, &second);
+}
+
+bool RayTable::middleSegment(const CellGrid &grid, int from, int to, bool optimal, int *first, int *second) const
+{
+    int stride = grid.stride();
+    int row1 = from / stride, col1 = from % stride;
+    int row2 = to / stride, col2 = to % stride;
+
+    // 代价 = 转折次数 * 格子总数 + 长度，长度一定小于格子总数
+    int bestCost = -1;
+    auto consider = [&](int p, int q, int turns, int length) {
+        int cost = turns * grid.size() + length;
+        if (bestCost < 0 || cost < bestCost) {
+            bestCost = cost;
+            *first = p;
+            *second = q;
+        }
+    };
+
+    // 横-竖-横：两端横向能走到的列取交集，逐列检查两行之间的竖直段
+    int lowCol = std::max(stop(from, Left) % stride, stop(to, Left) % stride) + 1;
+    int highCol = std::min(stop(from, Right) % stride, stop(to, Right) % stride) - 1;
+    for (int col = lowCol; col <= highCol; ++col) {
+        int p = row1 * stride + col;
+        int q = row2 * stride + col;
+        if (p == q || segmentClear(grid, p, q)) {
+            int turns = row1 == row2 ? 0 : (col != col1) + (col != col2);
+            consider(p, q, turns, std::abs(col - col1) + std::abs(row2 - row1) + std::abs(col2 - col));
+            if (!optimal) {
+                return true;
+            }
+        }
+    }
+
+    // 竖-横-竖：两端纵向能走到的行取交集，逐行检查两列之间的水平段
+    int lowRow = std::max(stop(from, Up) / stride, stop(to, Up) / stride) + 1;
+    int highRow = std::min(stop(from, Down) / stride, stop(to, Down) / stride) - 1;
+    for (int row = lowRow; row <= highRow; ++row) {
+        int p = row * stride + col1;
+        int q = row * stride + col2;
+        if (p == q || segmentClear(grid, p, q)) {
+            int turns = col1 == col2 ? 0 : (row != row1) + (row != row2);
+            consider(p, q, turns, std::abs(row - row1) + std::abs(col2 - col1) + std::abs(row2 - row));
+            if (!optimal) {
+                return true;
+            }
+        }
+    }
+    return bestCost >= 0;
+}
+
+int RayTable::findLink(const CellGrid &grid, int from, int to, int corners[4]) const
+{
+    int points[4];
+    if (from == to || !middleSegment(grid, from, to, true, &points[1], &points[2])) {
+        return 0;
+    }
+
+    // 中间一段长度为 0 说明两端在同一条直线上，只保留两端；否则去掉长度为 0 的线段
+    if (points[1] == points[2]) {
+        corners[0] = from;
+        corners[1] = to;
+        return 2;
+    }
+    points[0] = from;
+    points[3] = to;
+    int count = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (count == 0 || corners[count - 1] != points[i]) {
+            corners[count++] = points[i];
+        }
+    }
+    return count;
+}
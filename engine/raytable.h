@@ -0,0 +1,38 @@
+#ifndef RAYTABLE_H
+#define RAYTABLE_H
+
+#include "cellgrid.h"
+#include <vector>
+
+// 每个格子向左、右、上、下四个方向能走多远：记录该方向上第一个被占用格子的下标
+// 哨兵格子视为占用，所以射线一定会停下来
+// 某个格子由空变满（或相反）时，只需要更新它所在的那一段行和那一段列
+class RayTable
+{
+public:
+    enum Direction { Left = 0, Right = 1, Up = 2, Down = 3 };  // 与 CellGrid::neighbourOffsets 的顺序一致
+
+    void reset(const CellGrid &grid);
+    void update(const CellGrid &grid, int index);
+
+    // index 沿 direction 前进遇到的第一个被占用格子
+    int stop(int index, int direction) const { return stops[index * 4 + direction]; }
+
+    // 同一行或同一列的两个格子之间（不含两端）是否没有障碍
+    bool segmentClear(const CellGrid &grid, int from, int to) const;
+
+    // 两个格子能否用不超过两个转折的路线连接（不检查方块类型）
+    bool canLink(const CellGrid &grid, int from, int to) const;
+    // 同上，并给出最优路线的拐点下标（含起点和终点），返回拐点个数，不能连接时返回 0
+    // 最优指转折最少，其次经过的格子最少；仍然相同时取横-竖-横中列号最小的，其次竖-横-竖中行号最小的
+    int findLink(const CellGrid &grid, int from, int to, int corners[4]) const;
+
+private:
+    void fill(int from, int to, int step, int direction, int value);
+    // 找到中间一段的两个端点，optimal 为 false 时找到第一条就返回
+    bool middleSegment(const CellGrid &grid, int from, int to, bool optimal, int *first, int *second) const;
+
+    std::vector<int> stops;  // 下标为 格子 * 4 + 方向
+};
+
+#endif // RAYTABLE_H
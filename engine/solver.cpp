@@ -0,0 +1,499 @@
+#include "solver.h"
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <unordered_set>
+
+namespace {
+
+// 每个（格子, 类型）的随机键，用 splitmix64 现算，不需要存表
+uint64_t zobristKey(int index, int type)
+{
+    uint64_t x = static_cast<uint64_t>(index) * Board::MAX_BLOCK_TYPES + type + 1;
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+}
+
+// 按哈希的高位分段，每段一把锁，多个线程同时查表时很少争用
+class Solver::DeadTable
+{
+public:
+    bool contains(uint64_t key)
+    {
+        Shard &shard = shards[key >> SHARD_SHIFT];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.keys.count(key) > 0;
+    }
+
+    void insert(uint64_t key)
+    {
+        Shard &shard = shards[key >> SHARD_SHIFT];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.keys.insert(key);
+    }
+
+private:
+    static constexpr int SHARD_SHIFT = 58;
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_set<uint64_t> keys;
+    };
+    std::array<Shard, 64> shards;
+};
+
+// 任务是从初始局面出发的一串走法；线程从自己队列的末尾取（深度优先、缓存友好），
+// 从别的队列的开头窃取（靠近树根、通常更大的子树）
+class Solver::TaskPool
+{
+public:
+    using Task = std::vector<Candidate>;
+
+    explicit TaskPool(int threads)
+        : queues(threads), pending(0), queued(0), idle(0)
+    {
+    }
+
+    void push(int worker, Task task)
+    {
+        pending.fetch_add(1);
+        {
+            // 放进队列之后再计数，被唤醒的线程看到 queued > 0 时一定取得到
+            std::lock_guard<std::mutex> lock(queues[worker].mutex);
+            queues[worker].tasks.push_back(std::move(task));
+            queued.fetch_add(1);
+        }
+        std::lock_guard<std::mutex> lock(waitMutex);
+        changed.notify_one();
+    }
+
+    // 所有任务都已完成时返回 false
+    bool pop(int worker, Task *task)
+    {
+        idle.fetch_add(1);
+        while (true) {
+            for (int i = 0; i < static_cast<int>(queues.size()); ++i) {
+                Queue &queue = queues[(worker + i) % queues.size()];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (queue.tasks.empty()) {
+                    continue;
+                }
+                if (i == 0) {
+                    *task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                } else {
+                    *task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                }
+                queued.fetch_sub(1);
+                idle.fetch_sub(1);
+                return true;
+            }
+            // 睡到有新任务或者全部完成；条件在锁内检查，不会错过 push 和 finish 的通知
+            std::unique_lock<std::mutex> lock(waitMutex);
+            changed.wait(lock, [this] { return queued.load() > 0 || pending.load() == 0; });
+            if (pending.load() == 0) {
+                idle.fetch_sub(1);
+                return false;
+            }
+        }
+    }
+
+    // 停止搜索时正在执行的任务很快返回，最后一个 finish 把等待的线程全部叫醒
+    void finish()
+    {
+        if (pending.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(waitMutex);
+            changed.notify_all();
+        }
+    }
+
+    // 有线程在等任务、队列里又没有现成的任务时，正在搜索的线程应当拆分
+    bool hungry() const { return idle.load(std::memory_order_relaxed) > 0 && queued.load(std::memory_order_relaxed) == 0; }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+    std::vector<Queue> queues;
+    std::atomic<int> pending;  // 已提交还没完成的任务，正在执行的任务可能继续拆分
+    std::atomic<int> queued;   // 还在队列里的任务
+    std::atomic<int> idle;
+    std::mutex waitMutex;
+    std::condition_variable changed;  // push 和最后一个 finish 时通知
+};
+
+class Solver::Search
+{
+public:
+    enum class Outcome {
+        Solved,
+        Dead,
+        Aborted,   // 预算用完或者别的线程已经找到解
+        Delegated  // 部分分支交给了别的线程，这里不能断定是死局
+    };
+
+    Search(Solver *owner, const Board &board, TaskPool *pool, int worker);
+
+    // 先走完 prefix 再搜索；没有找到解时恢复到初始局面
+    Outcome run(const std::vector<Candidate> &prefix);
+    std::vector<Move> moves() const;
+
+private:
+    Outcome search(int depth);
+    void collectMoves(std::vector<Candidate> *moves) const;
+    void apply(const Candidate &move);
+    void undo(const Candidate &move);
+    void buildPotentialPartners();
+
+    Solver *owner;
+    TaskPool *pool;  // 单线程时为 nullptr
+    int worker;
+    Board work;  // 搜索时在副本上消除和恢复方块
+    uint64_t hash;  // 剩余方块（格子, 类型）的 Zobrist 哈希
+    std::vector<std::vector<Candidate>> moveStack;  // 每层深度一个，避免在搜索中分配
+    // 每层展开时的可消除对索引：子节点由它加上刚走的一步增量得到自己的索引，回溯之后不必整张重建
+    std::vector<PairIndex> indexStack;
+    int rootDepth;  // 本次 run 的 prefix 长度，更浅的层没有索引快照
+    std::vector<Candidate> trail;  // 从初始局面走到当前局面的走法
+
+    // 把其它方块全部消掉之后每个方块能连上的同类方块；某个方块的这些搭档都已消除时局面必死
+    bool tracked;
+    std::vector<std::vector<int>> potentialPartners;
+    std::vector<int> potentialLeft;  // potentialPartners 中还没有消除的个数
+    int stranded;  // potentialLeft 为 0 的剩余方块数
+};
+
+Solver::Search::Search(Solver *owner, const Board &board, TaskPool *pool, int worker)
+    : owner(owner), pool(pool), worker(worker), work(board), hash(0), rootDepth(0), tracked(false), stranded(0)
+{
+    for (int type = 0; type < Board::MAX_BLOCK_TYPES; ++type) {
+        for (int index : work.blocksOfType(type)) {
+            hash ^= zobristKey(index, type);
+        }
+    }
+    moveStack.resize(work.blockCount() / 2 + 1);
+    indexStack.resize(moveStack.size());
+    buildPotentialPartners();
+}
+
+Solver::Search::Outcome Solver::Search::run(const std::vector<Candidate> &prefix)
+{
+    for (const Candidate &move : prefix) {
+        apply(move);
+    }
+    rootDepth = static_cast<int>(prefix.size());
+    Outcome outcome = search(static_cast<int>(prefix.size()));
+    if (outcome != Outcome::Solved) {
+        for (auto it = prefix.rbegin(); it != prefix.rend(); ++it) {
+            undo(*it);
+        }
+    }
+    return outcome;
+}
+
+std::vector<Solver::Move> Solver::Search::moves() const
+{
+    const CellGrid &grid = work.cells();
+    std::vector<Move> result;
+    for (const Candidate &move : trail) {
+        result.push_back(Move{{grid.rowOf(move.first), grid.colOf(move.first)},
+                              {grid.rowOf(move.second), grid.colOf(move.second)}});
+    }
+    return result;
+}
+
+Solver::Search::Outcome Solver::Search::search(int depth)
+{
+    if (work.blockCount() == 0) {
+        return Outcome::Solved;
+    }
+    if (stranded > 0 || owner->deadStates->contains(hash)) {
+        return Outcome::Dead;
+    }
+    if (owner->outOfBudget(owner->nodes.fetch_add(1, std::memory_order_relaxed))) {
+        return Outcome::Aborted;
+    }
+
+    const CellGrid &grid = work.cells();
+    if (depth > rootDepth) {
+        // 刚走完一步的子节点才需要索引，被剪掉的子节点不用为它付出代价
+        const Candidate &last = trail.back();
+        work.deriveLinkablePairs(indexStack[depth - 1], grid.rowOf(last.first), grid.colOf(last.first),
+                                 grid.rowOf(last.second), grid.colOf(last.second));
+    }
+    std::vector<Candidate> &moves = moveStack[depth];
+    collectMoves(&moves);
+    // 逐个元素赋值，复用这一层上次留下的容量
+    indexStack[depth] = work.linkablePairs();
+    std::size_t count = moves.size();
+    bool delegated = false;
+    for (std::size_t i = 0; i < count; ++i) {
+        // 有线程空闲时，自己继续走第 i 步，后面的分支各作为一个任务交出去
+        if (pool && i + 1 < count && pool->hungry()) {
+            for (std::size_t j = i + 1; j < count; ++j) {
+                std::vector<Candidate> task = trail;
+                task.push_back(moves[j]);
+                pool->push(worker, std::move(task));
+            }
+            count = i + 1;
+            delegated = true;
+        }
+
+        Candidate move = moves[i];
+        apply(move);
+        Outcome outcome = search(depth + 1);
+        if (outcome == Outcome::Solved) {
+            return outcome;  // trail 中就是答案，副本不用再恢复
+        }
+        undo(move);
+        if (outcome == Outcome::Aborted) {
+            return outcome;
+        }
+        delegated = delegated || outcome == Outcome::Delegated;
+    }
+
+    // 只有完整搜索过的局面才记为死局
+    if (delegated) {
+        return Outcome::Delegated;
+    }
+    owner->deadStates->insert(hash);
+    return Outcome::Dead;
+}
+
+void Solver::Search::collectMoves(std::vector<Candidate> *moves) const
+{
+    moves->clear();
+    const PairIndex &pairs = work.linkablePairs();
+    const CellGrid &grid = work.cells();
+    int degreeScale = 2 * grid.size();
+    int typePairs[Board::MAX_BLOCK_TYPES] = {};
+
+    for (int cell : pairs.linkableCells()) {
+        for (int partner : pairs.partnersOf(cell)) {
+            if (partner < cell) {
+                continue;
+            }
+            int type = grid.code(cell) - CellGrid::CODE_BLOCK;
+            int remaining = work.countBlockType(type);
+            ++typePairs[type];
+
+            // 只能和对方配对的方块现在就消掉，不再分支
+            if (tracked && (potentialLeft[cell] == 1 || potentialLeft[partner] == 1)) {
+                moves->assign(1, Candidate{cell, partner, type, 0});
+                return;
+            }
+
+            // 剩得少的类型优先，其次是搭档少的方块
+            int degree = static_cast<int>(pairs.partnersOf(cell).size() + pairs.partnersOf(partner).size());
+            moves->push_back(Candidate{cell, partner, type, remaining * degreeScale + degree});
+        }
+    }
+
+    // 某种方块剩下的每两块都能连上时，直接消掉其中一对，不再分支：消除只会腾出格子，
+    // 这些方块之间以后仍然两两能连上，任何解都可以改成先把它们消完
+    for (const Candidate &move : *moves) {
+        int remaining = work.countBlockType(move.type);
+        if (typePairs[move.type] == remaining * (remaining - 1) / 2) {
+            Candidate forced = move;
+            moves->assign(1, forced);
+            return;
+        }
+    }
+
+    // 同分时按下标排序，结果只取决于局面
+    std::sort(moves->begin(), moves->end(), [](const Candidate &a, const Candidate &b) {
+        if (a.rank != b.rank) {
+            return a.rank < b.rank;
+        }
+        return a.first != b.first ? a.first < b.first : a.second < b.second;
+    });
+}
+
+void Solver::Search::apply(const Candidate &move)
+{
+    const CellGrid &grid = work.cells();
+    work.removePair(grid.rowOf(move.first), grid.colOf(move.first), grid.rowOf(move.second), grid.colOf(move.second));
+    hash ^= zobristKey(move.first, move.type) ^ zobristKey(move.second, move.type);
+    trail.push_back(move);
+
+    if (tracked) {
+        for (int cell : {move.first, move.second}) {
+            for (int partner : potentialPartners[cell]) {
+                if (--potentialLeft[partner] == 0 && grid.isBlock(partner)) {
+                    ++stranded;
+                }
+            }
+        }
+    }
+}
+
+void Solver::Search::undo(const Candidate &move)
+{
+    const CellGrid &grid = work.cells();
+    if (tracked) {
+        for (int cell : {move.first, move.second}) {
+            for (int partner : potentialPartners[cell]) {
+                if (potentialLeft[partner]++ == 0 && grid.isBlock(partner)) {
+                    --stranded;
+                }
+            }
+        }
+    }
+
+    work.setCell(grid.rowOf(move.first), grid.colOf(move.first), move.type);
+    work.setCell(grid.rowOf(move.second), grid.colOf(move.second), move.type);
+    hash ^= zobristKey(move.first, move.type) ^ zobristKey(move.second, move.type);
+    trail.pop_back();
+}
+
+void Solver::Search::buildPotentialPartners()
+{
+    // 消除只会腾出格子，所以两个方块以后能不能连上，不会超过“其它方块全部消掉”时的情况
+    // 默认规则下用位棋盘一次展开每个方块在这种棋盘上的可达范围；其它规则暂不跟踪
+    tracked = work.linkRule().maxTurns == 2 && !work.linkRule().allowOutside;
+    if (!tracked) {
+        return;
+    }
+
+    const CellGrid &grid = work.cells();
+    CellGrid cleared;
+    cleared.copyFrom(grid);
+    for (int index = 0; index < grid.size(); ++index) {
+        if (grid.isBlock(index)) {
+            cleared.setCode(index, CellGrid::CODE_EMPTY);
+        }
+    }
+    BitBoard bits;
+    bits.reset(cleared);
+
+    potentialPartners.resize(grid.size());
+    potentialLeft.assign(grid.size(), 0);
+    uint64_t rowReach[BitBoard::MAX_DIM];
+    uint64_t colReach[BitBoard::MAX_DIM];
+    for (int type = 0; type < Board::MAX_BLOCK_TYPES; ++type) {
+        const SparseCellSet &blocks = work.blocksOfType(type);
+        for (int cell : blocks) {
+            potentialPartners[cell].clear();
+            int row = grid.rowOf(cell);
+            int col = grid.colOf(cell);
+            bits.linkReach(row, col, rowReach, colReach);
+            for (int other : blocks) {
+                int r = grid.rowOf(other) + 1;
+                int c = grid.colOf(other) + 1;
+                if (other != cell && (((rowReach[r] >> c) & 1) || ((colReach[c] >> r) & 1))) {
+                    potentialPartners[cell].push_back(other);
+                }
+            }
+            potentialLeft[cell] = static_cast<int>(potentialPartners[cell].size());
+            if (potentialLeft[cell] == 0) {
+                ++stranded;
+            }
+        }
+    }
+}
+
+Solver::Solver()
+    : nodes(0), stopped(false), solved(false)
+{
+}
+
+Solver::~Solver() = default;
+
+Solver::Result Solver::solve(const Board &board, std::vector<Move> *witness)
+{
+    return solve(board, Limits(), witness);
+}
+
+Solver::Result Solver::solve(const Board &board, const Limits &limits, std::vector<Move> *witness)
+{
+    budget = limits;
+    startTime = std::chrono::steady_clock::now();
+    nodes = 0;
+    stopped = false;
+    solved = false;
+    solution.clear();
+    deadStates.reset(new DeadTable);
+    if (witness) {
+        witness->clear();
+    }
+
+    // 某种方块剩奇数个时永远消不完
+    for (int type = 0; type < Board::MAX_BLOCK_TYPES; ++type) {
+        if (board.countBlockType(type) % 2 != 0) {
+            return Result::Unsolvable;
+        }
+    }
+
+    int threads = limits.threads > 0 ? limits.threads : static_cast<int>(std::thread::hardware_concurrency());
+    if (threads <= 1) {
+        Search search(this, board, nullptr, 0);
+        if (search.run({}) == Search::Outcome::Solved) {
+            recordSolution(search.moves());
+        }
+    } else {
+        TaskPool pool(threads);
+        pool.push(0, {});
+        std::vector<std::thread> workers;
+        for (int i = 1; i < threads; ++i) {
+            workers.emplace_back(&Solver::runWorker, this, std::cref(board), &pool, i);
+        }
+        runWorker(board, &pool, 0);
+        for (std::thread &thread : workers) {
+            thread.join();
+        }
+    }
+
+    if (solved) {
+        if (witness) {
+            *witness = solution;
+        }
+        return Result::Solvable;
+    }
+    return stopped ? Result::Unknown : Result::Unsolvable;
+}
+
+void Solver::runWorker(const Board &board, TaskPool *pool, int worker)
+{
+    Search search(this, board, pool, worker);
+    std::vector<Candidate> task;
+    while (pool->pop(worker, &task)) {
+        // 已经停止时只把剩下的任务取完
+        if (!stopped.load() && search.run(task) == Search::Outcome::Solved) {
+            recordSolution(search.moves());
+        }
+        pool->finish();
+    }
+}
+
+bool Solver::outOfBudget(long long count)
+{
+    if (stopped.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    bool exhausted = count >= budget.maxNodes;
+    // 每 16 个节点看一次时钟：大地图上一个节点就要几十微秒，间隔太长会明显超时
+    if (!exhausted && budget.maxMilliseconds > 0 && (count & 15) == 0) {
+        exhausted = std::chrono::steady_clock::now() - startTime >= std::chrono::milliseconds(budget.maxMilliseconds);
+    }
+    if (exhausted) {
+        stopped.store(true);
+    }
+    return exhausted;
+}
+
+void Solver::recordSolution(const std::vector<Move> &moves)
+{
+    std::lock_guard<std::mutex> lock(solutionMutex);
+    if (!solved) {
+        solved = true;
+        solution = moves;
+    }
+    stopped.store(true);
+}
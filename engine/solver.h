@@ -0,0 +1,68 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "board.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// 整局可解性的精确判定：在消除顺序上做深度优先搜索，按棋盘当前的连接规则走子
+// 每个节点的可走步来自 Board 的可消除方块对索引，判定为死局的局面按 Zobrist 哈希记入置换表，
+// 不同顺序消到同一局面时不再重复搜索；超出节点数或时间预算时返回 Unknown
+// 多线程时有空闲线程就把当前节点剩下的分支拆成任务，放进工作窃取线程池；置换表和预算在线程之间共享，
+// 任何一个线程找到解后其余线程立即停止，此时给出的解可能随线程调度而不同
+class Solver
+{
+public:
+    enum class Result {
+        Solvable,
+        Unsolvable,
+        Unknown  // 预算内没有得出结论
+    };
+    struct Limits {
+        long long maxNodes = 50000;
+        int maxMilliseconds = 0;  // 0 表示不限时间
+        int threads = 1;          // 搜索线程数，0 表示每个核心一个
+    };
+    struct Move {
+        Board::Point first;
+        Board::Point second;
+    };
+
+    Solver();
+    ~Solver();
+
+    // 可解时 witness 依次写入一组能把方块全部消完的步骤
+    Result solve(const Board &board, std::vector<Move> *witness = nullptr);
+    Result solve(const Board &board, const Limits &limits, std::vector<Move> *witness = nullptr);
+    long long nodeCount() const { return nodes.load(); }
+
+private:
+    struct Candidate {
+        int first;
+        int second;
+        int type;
+        int rank;  // 越小越先尝试
+    };
+    class Search;     // 一个线程的搜索状态：棋盘副本、走子栈和剪枝计数
+    class DeadTable;  // 分段加锁的死局表
+    class TaskPool;   // 每个线程一个任务队列，自己的取完了就从别的队列窃取
+
+    void runWorker(const Board &board, TaskPool *pool, int worker);
+    bool outOfBudget(long long count);
+    void recordSolution(const std::vector<Move> &moves);
+
+    Limits budget;
+    std::chrono::steady_clock::time_point startTime;
+    std::atomic<long long> nodes;
+    std::atomic<bool> stopped;  // 已经找到解或者预算用完
+    std::unique_ptr<DeadTable> deadStates;
+    std::mutex solutionMutex;
+    bool solved;
+    std::vector<Move> solution;
+};
+
+#endif // SOLVER_H
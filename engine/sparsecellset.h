@@ -0,0 +1,60 @@
+#ifndef SPARSECELLSET_H
+#define SPARSECELLSET_H
+
+#include <vector>
+
+// 格子下标的稀疏集合：dense 紧凑保存成员，slot 记录每个下标在 dense 中的位置
+// 插入、删除、查询都是 O(1)，遍历只访问成员本身；删除时用最后一个成员填补空位，因此顺序不固定
+class SparseCellSet
+{
+public:
+    void reset(int capacity)
+    {
+        dense.clear();
+        dense.reserve(capacity);
+        slot.assign(capacity, -1);
+    }
+
+    void clear()
+    {
+        for (int index : dense) {
+            slot[index] = -1;
+        }
+        dense.clear();
+    }
+
+    bool contains(int index) const { return slot[index] >= 0; }
+    int size() const { return static_cast<int>(dense.size()); }
+    bool empty() const { return dense.empty(); }
+    int operator[](int i) const { return dense[i]; }
+    std::vector<int>::const_iterator begin() const { return dense.begin(); }
+    std::vector<int>::const_iterator end() const { return dense.end(); }
+
+    void insert(int index)
+    {
+        if (slot[index] >= 0) {
+            return;
+        }
+        slot[index] = static_cast<int>(dense.size());
+        dense.push_back(index);
+    }
+
+    void erase(int index)
+    {
+        int position = slot[index];
+        if (position < 0) {
+            return;
+        }
+        int last = dense.back();
+        dense[position] = last;
+        slot[last] = position;
+        dense.pop_back();
+        slot[index] = -1;
+    }
+
+private:
+    std::vector<int> dense;
+    std::vector<int> slot;
+};
+
+#endif // SPARSECELLSET_H
@@ -1,6 +1,6 @@
 #include "gameboard.h"
+#include "boardpool.h"
 #include <QGridLayout>
-#include <QRandomGenerator>
 #include <QIcon>
 #include <QMessageBox>
 #include <QFileDialog>
@@ -9,10 +9,15 @@
 
 void GameBoard::loadImages()
 {
-    blockImages.resize(3);  // 假设有3种不同的方块
-    blockImages[0] = QPixmap("://p1.jpg").scaled(CELL_SIZE, CELL_SIZE, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    blockImages[1] = QPixmap("://p2.jpg").scaled(CELL_SIZE, CELL_SIZE, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    blockImages[2] = QPixmap("://p3.jpg").scaled(CELL_SIZE, CELL_SIZE, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    // 缩放好的图片在所有对局之间共用，只在第一次开局时解码和缩放
+    static QVector<QPixmap> scaledImages;
+    if (scaledImages.isEmpty()) {
+        scaledImages.resize(3);  // 假设有3种不同的方块
+        scaledImages[0] = QPixmap("://p1.jpg").scaled(CELL_SIZE, CELL_SIZE, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        scaledImages[1] = QPixmap("://p2.jpg").scaled(CELL_SIZE, CELL_SIZE, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        scaledImages[2] = QPixmap("://p3.jpg").scaled(CELL_SIZE, CELL_SIZE, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    blockImages = scaledImages;
 
     // 确保图片加载成功
     for (const auto& img : blockImages) {
@@ -30,27 +35,23 @@ void GameBoard::drawMap(QGridLayout *layout)
         }
     }
 
-    buttons.resize(rows);
+    buttons.resize(board.rows());
 
-    for (int i = 0; i < rows; ++i) {
-        buttons[i].resize(cols);
-        for (int j = 0; j < cols; ++j) {
+    for (int i = 0; i < board.rows(); ++i) {
+        buttons[i].resize(board.cols());
+        for (int j = 0; j < board.cols(); ++j) {
             QPushButton *button = new QPushButton();
             button->setFixedSize(CELL_SIZE, CELL_SIZE);
 
-            int blockType = map[i][j];
-            if (blockType == -1) {
+            int blockType = board.cell(i, j);
+            if (blockType == Board::EMPTY) {
                 // 空地
                 button->setStyleSheet("background-color: lightgray; border: 1px solid gray;");
-            } else if (blockType == -2) {
+            } else if (blockType == Board::PROP) {
                 // 道具
-                for (const auto &prop : props) {
-                    if (prop.row == i && prop.col == j) {
-                        button->setStyleSheet(getPropStyleSheet(prop.type));
-                        button->setText(getPropText(prop.type));
-                        break;
-                    }
-                }
+                PropType propType = board.propAt(i, j);
+                button->setStyleSheet(getPropStyleSheet(propType));
+                button->setText(getPropText(propType));
             } else if (blockType >= 0 && blockType < blockImages.size()) {
                 // 普通方块
                 button->setIcon(QIcon(blockImages[blockType]));
@@ -133,77 +134,6 @@ void GameBoard::keyPressEvent(QKeyEvent *event)
     }
 }
 
-void GameBoard::generateMap()
-{
-    int totalCells = (rows - 2) * (cols - 2);  // 不包括边界
-
-    QVector<int> allItems;
-    int propCount = totalCells / 10;  // 10% 的格子是道具
-    int blockPairCount = (totalCells - propCount) / 2;
-
-    // 添加道具
-    for (int i = 0; i < propCount; ++i) {
-        allItems.push_back(-2);  // 使用 -2 表示道具
-    }
-
-    // 添加可消除方块
-    for (int i = 0; i < blockPairCount; ++i) {
-        int blockType = QRandomGenerator::global()->bounded(3);  // 生成0-2的随机数
-        allItems.push_back(blockType);
-        allItems.push_back(blockType);  // 每种类型都添加两次，确保可以配对
-    }
-
-    // 打乱方块和道具顺序
-    for (int i = allItems.size() - 1; i > 0; --i) {
-        int j = QRandomGenerator::global()->bounded(i + 1);
-        qSwap(allItems[i], allItems[j]);
-    }
-
-    // 填充地图
-    map.resize(rows);
-    for (int i = 0; i < rows; ++i) {
-        map[i].resize(cols);
-        for (int j = 0; j < cols; ++j) {
-            if (i == 0 || i == rows - 1 || j == 0 || j == cols - 1) {
-                map[i][j] = -1;  // 边界上没有方块
-            } else {
-                map[i][j] = allItems.takeLast();
-                if (map[i][j] == -2) {  // 如果是道具
-                    PropType propType;
-                    if (isTwoPlayerMode) {
-                        propType = static_cast<PropType>(QRandomGenerator::global()->bounded(5) + 1);
-                        if (propType == PropType::Flash) {
-                            propType = PropType::Dizzy;  // 替换 Flash 为 Dizzy
-                        }
-                    } else {
-                        propType = static_cast<PropType>(QRandomGenerator::global()->bounded(4) + 1);
-                    }
-                    props.push_back({propType, i, j});
-                }
-            }
-        }
-    }
-}
-
-bool GameBoard::isMapSolvable()
-{
-
-    return true;
-}
-
-int GameBoard::countBlockType(int type)
-{
-    int count = 0;
-    for (int i = 1; i < rows - 1; ++i) {
-        for (int j = 1; j < cols - 1; ++j) {
-            if (map[i][j] == type) {
-                count++;
-            }
-        }
-    }
-    return count;
-}
-
 void GameBoard::movePlayer(int player, int dx, int dy)
 {
     qDebug() << "Moving player" << player << "dx:" << dx << "dy:" << dy;
@@ -219,33 +149,22 @@ void GameBoard::movePlayer(int player, int dx, int dy)
         dy = -dy;
     }
 
-    int &playerRow = (player == 1) ? player1Row : player2Row;
-    int &playerCol = (player == 1) ? player1Col : player2Col;
-
-    int newRow = playerRow + dy;
-    int newCol = playerCol + dx;
+    Board::Point position = board.playerPosition(player);
+    int newRow = position.row + dy;
+    int newCol = position.col + dx;
 
-    if (newRow >= 0 && newRow < rows && newCol >= 0 && newCol < cols) {
-        if (map[newRow][newCol] == -2) {
+    if (board.contains(newRow, newCol)) {
+        if (board.cell(newRow, newCol) == Board::PROP) {
             // 触发道具效果
-            for (auto it = props.begin(); it != props.end(); ++it) {
-                if (it->row == newRow && it->col == newCol) {
-                    currentPlayer = player;  // 设置当前玩家
-                    activateProp(it->type);
-                    props.erase(it);
-                    break;
-                }
-            }
-            map[newRow][newCol] = -1;
-            buttons[newRow][newCol]->setStyleSheet("background-color: lightgray; border: 1px solid gray;");
-            buttons[newRow][newCol]->setText("");
-        } else if (map[newRow][newCol] >= 0) {
+            currentPlayer = player;  // 设置当前玩家
+            activateProp(board.propAt(newRow, newCol));
+            board.takeProp(newRow, newCol);
+        } else if (board.cell(newRow, newCol) >= 0) {
             activateBlock(player, newRow, newCol);
         }
 
-        playerRow = newRow;
-        playerCol = newCol;
-        updatePlayersPosition();
+        board.setPlayerPosition(player, newRow, newCol);
+        applyChanges();
     }
 }
 
@@ -260,34 +179,39 @@ void GameBoard::activateBlock(int player, int row, int col)
         block->setStyleSheet("background-color: yellow; border: 2px solid black;");
 
         if (isBlockActivated) {
-            if (map[row][col] == map[lastActivatedBlock.first][lastActivatedBlock.second] &&
+            if (board.cell(row, col) == board.cell(lastActivatedBlock.first, lastActivatedBlock.second) &&
                 (row != lastActivatedBlock.first || col != lastActivatedBlock.second)) {
 
-                // 检查是否可以用两个或以内的转折连接
-                QVector<QPoint> path = findPath(lastActivatedBlock.first, lastActivatedBlock.second, row, col);
-
-                if (!path.isEmpty()) {
+                // 按地图当前的连接规则（转折次数、能否绕到地图外）检查能否连接，可以则消除并计分
+                std::vector<Board::Point> path;
+                if (board.matchPair(player, lastActivatedBlock.first, lastActivatedBlock.second, row, col, &path)) {
                     // 消除方块
                     buttons[row][col]->hide();
                     buttons[lastActivatedBlock.first][lastActivatedBlock.second]->hide();
 
                     // 绘制连接线
-                    drawConnectionLine(lastActivatedBlock.first, lastActivatedBlock.second, row, col);
+                    drawConnectionLine(path);
 
-                    map[row][col] = -1;
-                    map[lastActivatedBlock.first][lastActivatedBlock.second] = -1;
                     isBlockActivated = false;
-                    addScore(player, 2);
+                    applyChanges();
 
                     // 检查游戏是否结束
-                    if (isGameFinished()) {
+                    if (board.isGameFinished()) {
                         endGame("恭喜！您已清除所有方块！");
                         return;
                     }
 
                     // 如果游戏没有结束，检查是否还有可以连接的方块对
-                    if (!hasMatchingPairs()) {
+                    // 还有能连接的对、但已经不可能消完时也提前打乱，不让玩家耗到时间结束
+                    if (!board.hasMatchingPairs()) {
                         shuffleBlocks();
+                    } else {
+                        // 在界面线程上运行，最多占用 DEADLOCK_CHECK_MS；结果只算一次
+                        Board::Deadlock deadlock = board.findDeadlock(DEADLOCK_CHECK_MS);
+                        if (deadlock != Board::Deadlock::None) {
+                            qDebug() << "Deadlock detected, shuffling:" << static_cast<int>(deadlock);
+                            shuffleBlocks();
+                        }
                     }
                 } else {
                     // 如果不能连接，更新lastActivatedBlock
@@ -309,19 +233,17 @@ void GameBoard::focusOutEvent(QFocusEvent *event)
     QTimer::singleShot(0, this, SLOT(setFocus()));
 }
 
-GameBoard::GameBoard(QWidget *parent, bool isTwoPlayerMode)
+GameBoard::GameBoard(QWidget *parent, bool isTwoPlayerMode, bool fromSave)
     : QWidget(parent), isTwoPlayerMode(isTwoPlayerMode),
-    player1Score(0), player2Score(0), isBlockActivated1(false), isBlockActivated2(false),
-    player1(nullptr), player2(nullptr), remainingTime(GAME_DURATION), isPaused(false),
+    board(fromSave ? Board(isTwoPlayerMode) : BoardPool::instance().take(isTwoPlayerMode)),  // 新游戏用后台预先生成好的地图
+    isBlockActivated1(false), isBlockActivated2(false),
+    player1(nullptr), player2(nullptr), isPaused(false),
     scene(nullptr), view(nullptr),isPlayer1Frozen(false), isPlayer2Frozen(false),
     isPlayer1Dizzy(false), isPlayer2Dizzy(false),hintTimer(nullptr)  // 初始化为 nullptr
 {
     qDebug() << "GameBoard constructor called with isTwoPlayerMode:" << isTwoPlayerMode;
 
-    rows = GRID_SIZE;
-    cols = GRID_SIZE;
     loadImages();
-    generateMap();
 
     QVBoxLayout *mainLayout = new QVBoxLayout(this);
     mainLayout->setSpacing(0);
@@ -334,15 +256,15 @@ GameBoard::GameBoard(QWidget *parent, bool isTwoPlayerMode)
     gridLayout->setContentsMargins(0, 0, 0, 0);
     drawMap(gridLayout);
 
-    gameMapWidget->setFixedSize(CELL_SIZE * cols, CELL_SIZE * rows);
+    gameMapWidget->setFixedSize(CELL_SIZE * board.cols(), CELL_SIZE * board.rows());
 
     // 创建场景和视图用于绘制连接线
     scene = new QGraphicsScene(this);
-    scene->setSceneRect(0, 0, CELL_SIZE * cols, CELL_SIZE * rows);
+    scene->setSceneRect(0, 0, CELL_SIZE * board.cols(), CELL_SIZE * board.rows());
     view = new QGraphicsView(scene, this);
     view->setStyleSheet("background: transparent;");
     view->setFrameStyle(QFrame::NoFrame);
-    view->setFixedSize(CELL_SIZE * cols, CELL_SIZE * rows);
+    view->setFixedSize(CELL_SIZE * board.cols(), CELL_SIZE * board.rows());
     view->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     view->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     view->setAlignment(Qt::AlignTop | Qt::AlignLeft);
@@ -350,8 +272,8 @@ GameBoard::GameBoard(QWidget *parent, bool isTwoPlayerMode)
     view->setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
 
     // 将所有按钮添加到场景中
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
+    for (int i = 0; i < board.rows(); ++i) {
+        for (int j = 0; j < board.cols(); ++j) {
             QPushButton *button = buttons[i][j];
             QGraphicsProxyWidget *proxy = new QGraphicsProxyWidget();
             proxy->setWidget(button);
@@ -388,12 +310,10 @@ GameBoard::GameBoard(QWidget *parent, bool isTwoPlayerMode)
         player2->setBrush(QBrush(Qt::blue));
         player2->setPen(QPen(Qt::black));
         scene->addItem(player2);
-        player2Row = rows - 2;
-        player2Col = cols - 2;
+        board.setPlayerPosition(2, board.rows() - 2, board.cols() - 2);
     }
 
-    player1Row = 1;
-    player1Col = 1;
+    board.setPlayerPosition(1, 1, 1);
 
     updatePlayersPosition();
 
@@ -432,7 +352,7 @@ GameBoard::GameBoard(QWidget *parent, bool isTwoPlayerMode)
     mainLayout->addLayout(buttonLayout);
 
     setLayout(mainLayout);
-    setFixedSize(CELL_SIZE * cols, CELL_SIZE * rows + infoWidget->sizeHint().height() + buttonLayout->sizeHint().height());
+    setFixedSize(CELL_SIZE * board.cols(), CELL_SIZE * board.rows() + infoWidget->sizeHint().height() + buttonLayout->sizeHint().height());
     // 创建游戏计时器
     gameTimer = new QTimer(this);
     connect(gameTimer, &QTimer::timeout, this, &GameBoard::updateTimer);
@@ -458,15 +378,17 @@ bool GameBoard::eventFilter(QObject *obj, QEvent *event)
 
 void GameBoard::updatePlayersPosition()
 {
+    Board::Point position1 = board.playerPosition(1);
+    Board::Point position2 = board.playerPosition(2);
     if (player1) {
-        int x1 = player1Col * CELL_SIZE + (CELL_SIZE - PLAYER_SIZE) / 2;
-        int y1 = player1Row * CELL_SIZE + (CELL_SIZE - PLAYER_SIZE) / 2;
+        int x1 = position1.col * CELL_SIZE + (CELL_SIZE - PLAYER_SIZE) / 2;
+        int y1 = position1.row * CELL_SIZE + (CELL_SIZE - PLAYER_SIZE) / 2;
         player1->setPos(x1, y1);
         player1->setZValue(Z_PLAYER);
     }
     if (isTwoPlayerMode && player2) {
-        int x2 = player2Col * CELL_SIZE + (CELL_SIZE - PLAYER_SIZE) / 2;
-        int y2 = player2Row * CELL_SIZE + (CELL_SIZE - PLAYER_SIZE) / 2;
+        int x2 = position2.col * CELL_SIZE + (CELL_SIZE - PLAYER_SIZE) / 2;
+        int y2 = position2.row * CELL_SIZE + (CELL_SIZE - PLAYER_SIZE) / 2;
         player2->setPos(x2, y2);
         player2->setZValue(Z_PLAYER);
     }
@@ -491,28 +413,19 @@ void GameBoard::updatePlayerTurnLabel()
 void GameBoard::updateScoreLabels()
 {
     if (isTwoPlayerMode) {
-        if (player1ScoreLabel) player1ScoreLabel->setText(QString("玩家1得分: %1").arg(player1Score));
-        if (player2ScoreLabel) player2ScoreLabel->setText(QString("玩家2得分: %1").arg(player2Score));
+        if (player1ScoreLabel) player1ScoreLabel->setText(QString("玩家1得分: %1").arg(board.score(1)));
+        if (player2ScoreLabel) player2ScoreLabel->setText(QString("玩家2得分: %1").arg(board.score(2)));
     } else {
-        if (player1ScoreLabel) player1ScoreLabel->setText(QString("得分: %1").arg(player1Score));
+        if (player1ScoreLabel) player1ScoreLabel->setText(QString("得分: %1").arg(board.score(1)));
     }
 }
 
 
-bool GameBoard::isGameFinished()
-{
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            if (map[i][j] >= 0) {  // 如果还有非空白、非道具的方块
-                return false;
-            }
-        }
-    }
-    return true;
-}
 void GameBoard::checkGameEnd()
 {
-    if (isGameFinished() || !hasMatchingPairs()) {
+    if (board.isGameFinished() || !board.hasMatchingPairs()) {
+        int player1Score = board.score(1);
+        int player2Score = board.score(2);
         QString message;
         if (isTwoPlayerMode) {
             if (player1Score > player2Score) {
@@ -535,70 +448,52 @@ void GameBoard::checkGameEnd()
 }
 void GameBoard::addScore(int player, int points)
 {
-    if (player == 1) {
-        player1Score += points;
-    } else {
-        player2Score += points;
-    }
-    updateScoreLabels();
+    board.addScore(player, points);
+    applyChanges();
 }
 void GameBoard::startGame()
 {
-    remainingTime = GAME_DURATION;
+    board.setRemainingTime(Board::GAME_DURATION);
     updateTimer();
     gameTimer->start(1000); // 每秒更新一次
 }
 void GameBoard::updateTimer()
 {
-    if (remainingTime > 0) {
-        remainingTime--;
-        int minutes = remainingTime / 60;
-        int seconds = remainingTime % 60;
-        timerLabel->setText(QString("剩余时间: %1:%2")
-                                .arg(minutes, 2, 10, QChar('0'))
-                                .arg(seconds, 2, 10, QChar('0')));
+    if (board.tick()) {
+        applyChanges();
     } else {
         endGame("时间到！");
     }
 }
+void GameBoard::updateTimerLabel()
+{
+    int minutes = board.remainingTime() / 60;
+    int seconds = board.remainingTime() % 60;
+    timerLabel->setText(QString("剩余时间: %1:%2")
+                            .arg(minutes, 2, 10, QChar('0'))
+                            .arg(seconds, 2, 10, QChar('0')));
+}
+
 void GameBoard::endGame(const QString &reason)
 {
     gameTimer->stop();
     QString message = reason + "\n";
     if (isTwoPlayerMode) {
-        if (player1Score > player2Score) {
+        if (board.score(1) > board.score(2)) {
             message += "玩家1获胜！";
-        } else if (player2Score > player1Score) {
+        } else if (board.score(2) > board.score(1)) {
             message += "玩家2获胜！";
         } else {
             message += "平局！";
         }
     } else {
-        message += QString("你的得分: %1").arg(player1Score);
+        message += QString("你的得分: %1").arg(board.score(1));
     }
     QMessageBox::information(this, "游戏结束", message);
 
     //添加一些代码来禁用游戏板或重置游戏
     setEnabled(false);  // 禁用整个游戏板
 }
-bool GameBoard::hasMatchingPairs()
-{
-    for (int i = 1; i < rows - 1; ++i) {
-        for (int j = 1; j < cols - 1; ++j) {
-            if (map[i][j] != -1) {
-                for (int x = 1; x < rows - 1; ++x) {
-                    for (int y = 1; y < cols - 1; ++y) {
-                        if ((i != x || j != y) && map[i][j] == map[x][y]) {
-                            return true;
-                        }
-                    }
-                }
-            }
-        }
-    }
-    return false;
-}
-
 void GameBoard::setupPauseMenu()
 {
     pauseButton = new QPushButton("暂停", this);
@@ -674,33 +569,36 @@ void GameBoard::saveGame(const QString &fileName)
         out << isTwoPlayerMode;
 
         // 保存地图大小和内容
-        out << rows << cols;
-        for (int i = 0; i < rows; ++i) {
-            for (int j = 0; j < cols; ++j) {
-                out << map[i][j];
+        out << board.rows() << board.cols();
+        for (int i = 0; i < board.rows(); ++i) {
+            for (int j = 0; j < board.cols(); ++j) {
+                out << board.cell(i, j);
             }
         }
 
         // 保存玩家位置
-        out << player1Row << player1Col;
+        out << board.playerPosition(1).row << board.playerPosition(1).col;
         if (isTwoPlayerMode) {
-            out << player2Row << player2Col;
+            out << board.playerPosition(2).row << board.playerPosition(2).col;
         }
 
         // 保存分数
-        out << player1Score;
+        out << board.score(1);
         if (isTwoPlayerMode) {
-            out << player2Score;
+            out << board.score(2);
         }
 
         // 保存剩余时间
-        out << remainingTime;
+        out << board.remainingTime();
 
         // 保存道具信息
-        out << props.size();
-        for (const auto &prop : props) {
+        out << static_cast<qsizetype>(board.propCount());
+        board.forEachProp([&out](const Board::Prop &prop) {
             out << static_cast<int>(prop.type) << prop.row << prop.col;
-        }
+        });
+
+        // 保存连接规则
+        out << board.linkRule().maxTurns << board.linkRule().allowOutside;
 
         file.close();
         qDebug() << "Game saved successfully.";
@@ -749,6 +647,7 @@ void GameBoard::loadGame(const QString &fileName)
         try {
             // 读取游戏模式
             in >> isTwoPlayerMode;
+            board.setTwoPlayerMode(isTwoPlayerMode);
             qDebug() << "Loaded game mode:" << (isTwoPlayerMode ? "Two Player" : "Single Player");
 
             // 读取地图大小和内容
@@ -764,13 +663,17 @@ void GameBoard::loadGame(const QString &fileName)
             // 调整地图大小
             resizeMap(loadedRows, loadedCols);
 
-            for (int i = 0; i < rows; ++i) {
-                for (int j = 0; j < cols; ++j) {
-                    in >> map[i][j];
+            for (int i = 0; i < board.rows(); ++i) {
+                for (int j = 0; j < board.cols(); ++j) {
+                    int value;
+                    in >> value;
+                    board.setCell(i, j, value);
                 }
             }
 
             // 读取玩家位置
+            int player1Row, player1Col;
+            int player2Row = 0, player2Col = 0;
             in >> player1Row >> player1Col;
             qDebug() << "Player 1 position:" << player1Row << "," << player1Col;
             if (isTwoPlayerMode) {
@@ -779,39 +682,63 @@ void GameBoard::loadGame(const QString &fileName)
             }
 
             // 检查玩家位置是否合法
-            if (player1Row < 0 || player1Row >= rows || player1Col < 0 || player1Col >= cols ||
-                (isTwoPlayerMode && (player2Row < 0 || player2Row >= rows || player2Col < 0 || player2Col >= cols))) {
+            if (player1Row < 0 || player1Row >= board.rows() || player1Col < 0 || player1Col >= board.cols() ||
+                (isTwoPlayerMode && (player2Row < 0 || player2Row >= board.rows() || player2Col < 0 || player2Col >= board.cols()))) {
                 throw std::runtime_error("Invalid player position in save file.");
             }
+            board.setPlayerPosition(1, player1Row, player1Col);
+            if (isTwoPlayerMode) {
+                board.setPlayerPosition(2, player2Row, player2Col);
+            }
 
             // 读取分数
+            int player1Score = 0;
+            int player2Score = 0;
             in >> player1Score;
             qDebug() << "Player 1 score:" << player1Score;
             if (isTwoPlayerMode) {
                 in >> player2Score;
                 qDebug() << "Player 2 score:" << player2Score;
             }
+            board.setScore(1, player1Score);
+            board.setScore(2, player2Score);
 
             // 读取剩余时间
+            int remainingTime;
             in >> remainingTime;
+            board.setRemainingTime(remainingTime);
             qDebug() << "Remaining time:" << remainingTime;
 
             // 读取道具信息
             qsizetype propCount;
             in >> propCount;
             qDebug() << "Number of props:" << propCount;
-            props.clear();
             for (int i = 0; i < propCount; ++i) {
                 int type, row, col;
                 in >> type >> row >> col;
-                if (row >= 0 && row < rows && col >= 0 && col < cols) {
-                    props.push_back({static_cast<PropType>(type), row, col});
+                if (board.contains(row, col)) {
+                    board.addProp(static_cast<PropType>(type), row, col);
                     qDebug() << "Loaded prop:" << type << "at" << row << "," << col;
                 } else {
                     qDebug() << "Skipped invalid prop at position:" << row << "," << col;
                 }
             }
 
+            // 读取连接规则，旧存档没有这一项，使用默认规则
+            Board::LinkRule rule;
+            if (!in.atEnd()) {
+                in >> rule.maxTurns >> rule.allowOutside;
+                if (!Board::isValidLinkRule(rule)) {
+                    throw std::runtime_error("Invalid link rule in save file.");
+                }
+            }
+            board.setLinkRule(rule);
+
+            // 检查计数器与读入的地图是否一致
+            if (!board.verifyCounters()) {
+                throw std::runtime_error("Inconsistent board state in save file.");
+            }
+
             file.close();
             qDebug() << "Game loaded successfully.";
 
@@ -820,9 +747,9 @@ void GameBoard::loadGame(const QString &fileName)
 
             loadPlayersPosition();
             updateUI();
-            for (const auto &prop : props) {
+            board.forEachProp([this](const Board::Prop &prop) {
                 updateBlockAppearance(prop.row, prop.col);
-            }
+            });
             updateBlockAppearance(player1Row, player1Col);
             if (isTwoPlayerMode) {
                 updateBlockAppearance(player2Row, player2Col);
@@ -841,8 +768,8 @@ void GameBoard::loadGame(const QString &fileName)
         scene->update();
     }
     // 强制更新所有元素
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
+    for (int i = 0; i < board.rows(); ++i) {
+        for (int j = 0; j < board.cols(); ++j) {
             updateBlockAppearance(i, j);
         }
     }
@@ -851,9 +778,9 @@ void GameBoard::loadGame(const QString &fileName)
     updatePlayerPositions();
 
     // 更新道具显示
-    for (const auto &prop : props) {
+    board.forEachProp([this](const Board::Prop &prop) {
         updateBlockAppearance(prop.row, prop.col);
-    }
+    });
 
     // 强制重绘
     update();
@@ -861,24 +788,21 @@ void GameBoard::loadGame(const QString &fileName)
 
 void GameBoard::updatePlayerPositions()
 {
+    Board::Point position1 = board.playerPosition(1);
+    Board::Point position2 = board.playerPosition(2);
     if (player1) {
-        player1->setPos(player1Col * CELL_SIZE + (CELL_SIZE - PLAYER_SIZE) / 2, player1Row * CELL_SIZE + (CELL_SIZE - PLAYER_SIZE) / 2);
+        player1->setPos(position1.col * CELL_SIZE + (CELL_SIZE - PLAYER_SIZE) / 2, position1.row * CELL_SIZE + (CELL_SIZE - PLAYER_SIZE) / 2);
         player1->setZValue(1000);
     }
     if (isTwoPlayerMode && player2) {
-        player2->setPos(player2Col * CELL_SIZE + (CELL_SIZE - PLAYER_SIZE) / 2, player2Row * CELL_SIZE + (CELL_SIZE - PLAYER_SIZE) / 2);
+        player2->setPos(position2.col * CELL_SIZE + (CELL_SIZE - PLAYER_SIZE) / 2, position2.row * CELL_SIZE + (CELL_SIZE - PLAYER_SIZE) / 2);
         player2->setZValue(1000);
     }
 }
 
 void GameBoard::resizeMap(int newRows, int newCols)
 {
-    rows = newRows;
-    cols = newCols;
-    map.resize(rows);
-    for (int i = 0; i < rows; ++i) {
-        map[i].resize(cols);
-    }
+    board.resize(newRows, newCols);
 }
 
 void GameBoard::initializeGameBoard()
@@ -900,10 +824,10 @@ void GameBoard::initializeGameBoard()
     this->drawMap(gridLayout);
 
     /*
-    buttons.resize(rows);
-    for (int i = 0; i < rows; ++i) {
-        buttons[i].resize(cols);
-        for (int j = 0; j < cols; ++j) {
+    buttons.resize(board.rows());
+    for (int i = 0; i < board.rows(); ++i) {
+        buttons[i].resize(board.cols());
+        for (int j = 0; j < board.cols(); ++j) {
             buttons[i][j] = new QPushButton(this);
             buttons[i][j]->setGeometry(j * CELL_SIZE, i * CELL_SIZE, CELL_SIZE, CELL_SIZE);
             buttons[i][j]->show();
@@ -912,20 +836,20 @@ void GameBoard::initializeGameBoard()
 
     // 重新设置游戏板大小
     //setFixedSize(cols * CELL_SIZE, rows * CELL_SIZE);
-    setFixedSize(CELL_SIZE * cols, CELL_SIZE * rows + infoWidget->sizeHint().height() + buttonLayout->sizeHint().height());
+    setFixedSize(CELL_SIZE * board.cols(), CELL_SIZE * board.rows() + infoWidget->sizeHint().height() + buttonLayout->sizeHint().height());
 
     // 初始化或重置其他游戏元素
     if (!player1ScoreLabel) {
         player1ScoreLabel = new QLabel(this);
     }
-    player1ScoreLabel->setGeometry(10, rows * CELL_SIZE + 10, 200, 30);
+    player1ScoreLabel->setGeometry(10, board.rows() * CELL_SIZE + 10, 200, 30);
     player1ScoreLabel->show();
 
     if (isTwoPlayerMode) {
         if (!player2ScoreLabel) {
             player2ScoreLabel = new QLabel(this);
         }
-        player2ScoreLabel->setGeometry(cols * CELL_SIZE - 210, rows * CELL_SIZE + 10, 200, 30);
+        player2ScoreLabel->setGeometry(board.cols() * CELL_SIZE - 210, board.rows() * CELL_SIZE + 10, 200, 30);
         player2ScoreLabel->show();
     }
 
@@ -933,7 +857,7 @@ void GameBoard::initializeGameBoard()
     if (!timerLabel) {
         timerLabel = new QLabel(this);
     }
-    timerLabel->setGeometry((cols * CELL_SIZE - 100) / 2, rows * CELL_SIZE + 10, 100, 30);
+    timerLabel->setGeometry((board.cols() * CELL_SIZE - 100) / 2, board.rows() * CELL_SIZE + 10, 100, 30);
     timerLabel->show();
     qDebug() << "Game board initialized.";
 }
@@ -942,8 +866,8 @@ void GameBoard::connectButtons()
 {
     qDebug() << "connectButtons";
 
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
+    for (int i = 0; i < board.rows(); ++i) {
+        for (int j = 0; j < board.cols(); ++j) {
             connect(buttons[i][j], &QPushButton::pressed, this, [this, i, j]() {
                 handleButtonClick(i, j);
                 });
@@ -954,39 +878,70 @@ void GameBoard::connectButtons()
 void GameBoard::handleButtonClick(int row, int col)
 {
     qDebug() << "Button clicked at row:" << row << "col:" << col;
+    Board::Point position = board.playerPosition(1);
 
     if (isFlashActive) {
         // 处理 Flash 模式下的点击
-        if (canReachPosition(player1Row, player1Col, row, col)) {
-            movePlayerToNearestEmptyCell(1, row, col);
-            if (map[row][col] >= 0) {
-                activateBlock(1, row, col);
-            }
-        }
+        flashPlayerTo(1, row, col);
     } else {
         // 处理普通模式下的点击
-        int dx = row - player1Row;
-        int dy = col - player1Col;
+        int dx = row - position.row;
+        int dy = col - position.col;
 
         if ((abs(dx) == 1 && dy == 0) || (dx == 0 && abs(dy) == 1)) {
             movePlayer(1, dx, dy);
         }
     }
 
-    updateUI();
+    applyChanges();
 }
 
-void GameBoard::loadPlayersPosition()
+void GameBoard::applyChanges()
 {
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            updateBlockAppearance(i, j);
+    Board::ChangeSet changes = board.takeChanges();
+    if (changes.empty()) {
+        return;
+    }
+
+    // 整张地图被替换时全部重绘，否则只重绘变化的格子
+    if (changes.layout) {
+        updateAllBlockAppearances();
+        updatePlayerCells();  // 只补画玩家所在的格子，不再整张重绘一遍
+    } else {
+        for (const Board::Point &cell : changes.cells) {
+            updateBlockAppearance(cell.row, cell.col);
+            updatePlayerAppearance(cell.row, cell.col);
+            // 保留当前选中方块的高亮
+            if (isBlockActivated && lastActivatedBlock == qMakePair(cell.row, cell.col)) {
+                buttons[cell.row][cell.col]->setStyleSheet("background-color: yellow; border: 2px solid black;");
+            }
         }
     }
 
-    updatePlayerAppearance(player1Row, player1Col);
+    if (changes.players) {
+        updatePlayersPosition();
+    }
+    if (changes.scores) {
+        updateScoreLabels();
+    }
+    if (changes.timer) {
+        updateTimerLabel();
+    }
+}
+
+void GameBoard::loadPlayersPosition()
+{
+    updateAllBlockAppearances();
+    updatePlayerCells();
+}
+
+void GameBoard::updatePlayerCells()
+{
+    Board::Point position1 = board.playerPosition(1);
+    Board::Point position2 = board.playerPosition(2);
+    updatePlayerAppearance(position1.row, position1.col);
     if (isTwoPlayerMode) {
-        updatePlayerAppearance(player2Row, player2Col);
+        updatePlayerAppearance(position2.row, position2.col);
     }
 }
 
@@ -997,22 +952,22 @@ void GameBoard::updateScoreDisplay()
     if (!player1ScoreLabel) {
         qDebug() << "Player 1 score label is null. Creating new label.";
         player1ScoreLabel = new QLabel(this);
-        player1ScoreLabel->setGeometry(10, rows * CELL_SIZE + 10, 200, 30);
+        player1ScoreLabel->setGeometry(10, board.rows() * CELL_SIZE + 10, 200, 30);
     }
 
-    qDebug() << "Updating player 1 score:" << player1Score;
-    player1ScoreLabel->setText(QString("玩家1分数: %1").arg(player1Score));
+    qDebug() << "Updating player 1 score:" << board.score(1);
+    player1ScoreLabel->setText(QString("玩家1分数: %1").arg(board.score(1)));
     player1ScoreLabel->show();
 
     if (isTwoPlayerMode) {
         if (!player2ScoreLabel) {
             qDebug() << "Player 2 score label is null. Creating new label.";
             player2ScoreLabel = new QLabel(this);
-            player2ScoreLabel->setGeometry(cols * CELL_SIZE - 210, rows * CELL_SIZE + 10, 200, 30);
+            player2ScoreLabel->setGeometry(board.cols() * CELL_SIZE - 210, board.rows() * CELL_SIZE + 10, 200, 30);
         }
 
-        qDebug() << "Updating player 2 score:" << player2Score;
-        player2ScoreLabel->setText(QString("玩家2分数: %1").arg(player2Score));
+        qDebug() << "Updating player 2 score:" << board.score(2);
+        player2ScoreLabel->setText(QString("玩家2分数: %1").arg(board.score(2)));
         player2ScoreLabel->show();
     } else {
         qDebug() << "Single player mode detected";
@@ -1034,12 +989,12 @@ void GameBoard::loadTimer()
     if (!timerLabel) {
         qDebug() << "Timer label is null. Creating new label.";
         timerLabel = new QLabel(this);
-        timerLabel->setGeometry((cols * CELL_SIZE - 100) / 2, rows * CELL_SIZE + 10, 100, 30);
+        timerLabel->setGeometry((board.cols() * CELL_SIZE - 100) / 2, board.rows() * CELL_SIZE + 10, 100, 30);
     }
 
-    qDebug() << "Updating remaining time:" << remainingTime;
-    int minutes = remainingTime / 60;
-    int seconds = remainingTime % 60;
+    qDebug() << "Updating remaining time:" << board.remainingTime();
+    int minutes = board.remainingTime() / 60;
+    int seconds = board.remainingTime() % 60;
     timerLabel->setText(QString("剩余时间: %1:%2")
                             .arg(minutes, 2, 10, QChar('0'))
                             .arg(seconds, 2, 10, QChar('0')));
@@ -1051,11 +1006,12 @@ void GameBoard::loadTimer()
 void GameBoard::updateUI()
 {
     qDebug() << "Entering updateUI()";
+    board.takeChanges();  // 全部重绘，之前记录的变化不再需要
       qDebug() << buttons[0][0];
     // 更新方块显示
     qDebug() << "Updating block appearances...";
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
+    for (int i = 0; i < board.rows(); ++i) {
+        for (int j = 0; j < board.cols(); ++j) {
             if (i < buttons.size() && j < buttons[i].size() && buttons[i][j]) {
                 updateBlockAppearance(i, j);
             } else {
@@ -1082,14 +1038,10 @@ void GameBoard::updateUI()
 
     // 更新道具显示
     qDebug() << "Updating props display...";
-    for (const auto &prop : props) {
-        if (prop.row >= 0 && prop.row < rows && prop.col >= 0 && prop.col < cols) {
-            updateBlockAppearance(prop.row, prop.col);
-            qDebug() << "Updated prop display at" << prop.row << "," << prop.col;
-        } else {
-            qDebug() << "Warning: Invalid prop position" << prop.row << "," << prop.col;
-        }
-    }
+    board.forEachProp([this](const Board::Prop &prop) {
+        updateBlockAppearance(prop.row, prop.col);
+        qDebug() << "Updated prop display at" << prop.row << "," << prop.col;
+    });
     qDebug() << "Props display updated.";
 
     // 刷新整个游戏板
@@ -1101,8 +1053,8 @@ void GameBoard::updateUI()
 
 void GameBoard::updateAllBlockAppearances()
 {
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
+    for (int i = 0; i < board.rows(); ++i) {
+        for (int j = 0; j < board.cols(); ++j) {
             updateBlockAppearance(i, j);
         }
     }
@@ -1111,8 +1063,8 @@ void GameBoard::updateAllBlockAppearances()
 void GameBoard::setupGame()
 {
     qDebug() << "Setting up game with isTwoPlayerMode:" << isTwoPlayerMode;
-    // 生成地图
-    generateMap();
+    // 从预先生成的地图中取一张
+    board = BoardPool::instance().take(isTwoPlayerMode);
 
     // 设置暂停菜单
     setupPauseMenu();
@@ -1151,64 +1103,89 @@ void GameBoard::updateGameBoard()
 }
 void GameBoard::serializeGame(QDataStream &out)
 {
-    out << isTwoPlayerMode << rows << cols << player1Score << player2Score
-        << player1Row << player1Col << player2Row << player2Col
-        << remainingTime << currentPlayer << isPaused;
+    out << isTwoPlayerMode << board.rows() << board.cols() << board.score(1) << board.score(2)
+        << board.playerPosition(1).row << board.playerPosition(1).col
+        << board.playerPosition(2).row << board.playerPosition(2).col
+        << board.remainingTime() << currentPlayer << isPaused;
 
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            out << map[i][j];
+    for (int i = 0; i < board.rows(); ++i) {
+        for (int j = 0; j < board.cols(); ++j) {
+            out << board.cell(i, j);
         }
     }
 
     // 序列化道具信息
-    out << props.size();
-    for (const auto &prop : props) {
+    out << board.propCount();
+    board.forEachProp([&out](const Board::Prop &prop) {
         out << static_cast<int>(prop.type) << prop.row << prop.col;
-    }
+    });
+
+    // 序列化连接规则
+    out << board.linkRule().maxTurns << board.linkRule().allowOutside;
 }
 
 void GameBoard::deserializeGame(QDataStream &in)
 {
+    int rows, cols, player1Score, player2Score, remainingTime;
+    int player1Row, player1Col, player2Row, player2Col;
     in >> isTwoPlayerMode >> rows >> cols >> player1Score >> player2Score
         >> player1Row >> player1Col >> player2Row >> player2Col
         >> remainingTime >> currentPlayer >> isPaused;
 
-    map.resize(rows);
+    board.setTwoPlayerMode(isTwoPlayerMode);
+    board.resize(rows, cols);
+    board.setScore(1, player1Score);
+    board.setScore(2, player2Score);
+    board.setRemainingTime(remainingTime);
+    board.setPlayerPosition(1, player1Row, player1Col);
+    board.setPlayerPosition(2, player2Row, player2Col);
     for (int i = 0; i < rows; ++i) {
-        map[i].resize(cols);
         for (int j = 0; j < cols; ++j) {
-            in >> map[i][j];
+            int value;
+            in >> value;
+            board.setCell(i, j, value);
         }
     }
 
     // 反序列化道具信息
     int propCount;
     in >> propCount;
-    props.clear();
     for (int i = 0; i < propCount; ++i) {
         int type, row, col;
         in >> type >> row >> col;
-        props.push_back({static_cast<PropType>(type), row, col});
+        board.addProp(static_cast<PropType>(type), row, col);
+    }
+
+    // 反序列化连接规则，旧数据没有这一项时使用默认规则
+    Board::LinkRule rule;
+    if (!in.atEnd()) {
+        in >> rule.maxTurns >> rule.allowOutside;
+        if (!Board::isValidLinkRule(rule)) {
+            throw std::runtime_error("Invalid link rule in save file.");
+        }
+    }
+    board.setLinkRule(rule);
+
+    if (!board.verifyCounters()) {
+        throw std::runtime_error("Inconsistent board state in save file.");
     }
 }
 
-void GameBoard::drawConnectionLine(int row1, int col1, int row2, int col2)
+void GameBoard::drawConnectionLine(const std::vector<Board::Point> &path)
 {
     clearConnectionLines();
 
-    QVector<QPoint> path = findPath(row1, col1, row2, col2);
-    if (path.isEmpty() || !scene) {
+    if (path.empty() || !scene) {
         return;
     }
 
     QPainterPath painterPath;
-    QPoint start = path[0];
-    painterPath.moveTo(start.x() * CELL_SIZE + CELL_SIZE / 2, start.y() * CELL_SIZE + CELL_SIZE / 2);
+    const Board::Point &start = path[0];
+    painterPath.moveTo(start.col * CELL_SIZE + CELL_SIZE / 2, start.row * CELL_SIZE + CELL_SIZE / 2);
 
-    for (int i = 1; i < path.size(); ++i) {
-        QPoint end = path[i];
-        painterPath.lineTo(end.x() * CELL_SIZE + CELL_SIZE / 2, end.y() * CELL_SIZE + CELL_SIZE / 2);
+    for (size_t i = 1; i < path.size(); ++i) {
+        const Board::Point &end = path[i];
+        painterPath.lineTo(end.col * CELL_SIZE + CELL_SIZE / 2, end.row * CELL_SIZE + CELL_SIZE / 2);
     }
 
     QPen pen(Qt::red, 3);
@@ -1236,184 +1213,42 @@ void GameBoard::clearConnectionLines()
     view->viewport()->update();  // 更新视图的视口
 }
 
-bool GameBoard::allBlocksCleared()
-{
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            if (map[i][j] >= 0) {  // 如果还有非空白、非道具的方块
-                return false;
-            }
-        }
-    }
-    return true;
-}
-
-QVector<QPoint> GameBoard::findPathBFS(int row1, int col1, int row2, int col2)
-{
-    struct PathNode {
-        int row, col;
-        QVector<QPoint> path;
-        int turns;
-        int direction; // 0: 初始, 1: 水平, 2: 垂直
-    };
-
-    QQueue<PathNode> queue;
-    QVector<QVector<QVector<bool>>> visited(rows, QVector<QVector<bool>>(cols, QVector<bool>(3, false)));
-
-    queue.enqueue({row1, col1, {{col1, row1}}, 0, 0});
-    visited[row1][col1][0] = true;
-
-    while (!queue.isEmpty()) {
-
-
-        PathNode current = queue.dequeue();
-        qDebug() << queue.size() << " " << current.row << "," << current.col << " " << row2 << "," << col2;
-
-        if (current.row == row2 && current.col == col2) {
-            qDebug() << "path size: " << current.path.size();
-            return current.path;
-        }
-
-        static const int dr[] = {0, 0, -1, 1};
-        static const int dc[] = {-1, 1, 0, 0};
-
-        for (int i = 0; i < 4; ++i) {
-            int newRow = current.row + dr[i];
-            int newCol = current.col + dc[i];
-            int newDirection = (i < 2) ? 1 : 2;
-            int newTurns = current.turns + (current.direction != newDirection && current.direction != 0);
-
-            if (newRow >= 0 && newRow < rows && newCol >= 0 && newCol < cols &&
-                !visited[newRow][newCol][newDirection] &&
-                (isEmptyOrBorder(newRow, newCol) || (newRow == row2 && newCol == col2)) &&
-                newTurns <= 2) {
-
-                bool pathClear = true;
-                if (newDirection == 1) { // 水平移动
-                    int minCol = qMin(newCol, current.col);
-                    int maxCol = qMax(newCol, current.col);
-                    for (int c = minCol + 1; c < maxCol; ++c) {
-                        if (!isEmptyOrBorder(current.row, c) && !(current.row == row2 && c == col2)) {
-                            pathClear = false;
-                            break;
-                        }
-                    }
-                } else { // 垂直移动
-                    int minRow = qMin(newRow, current.row);
-                    int maxRow = qMax(newRow, current.row);
-                    for (int r = minRow + 1; r < maxRow; ++r) {
-                        if (!isEmptyOrBorder(r, current.col) && !(r == row2 && current.col == col2)) {
-                            pathClear = false;
-                            break;
-                        }
-                    }
-                }
-
-                if (pathClear) {
-                    QVector<QPoint> newPath = current.path;
-                    newPath.append(QPoint(newCol, newRow));
-                    queue.enqueue({newRow, newCol, newPath, newTurns, newDirection});
-                    visited[newRow][newCol][newDirection] = true;
-                }
-            }
-        }
-    }
-
-    return QVector<QPoint>();
-}
-
-QVector<QPoint> GameBoard::findPath(int row1, int col1, int row2, int col2)
-{
-    qDebug() << "Finding path between (" << row1 << "," << col1 << ") and (" << row2 << "," << col2 << ")";
-
-    // 检查是否可以连接
-    if (!canConnect(row1, col1, row2, col2)) {
-        qDebug() << "Cannot connect these blocks";
-        return QVector<QPoint>();
-    }
-
-    return findPathBFS(row1, col1, row2, col2);
-}
-
-bool GameBoard::isEmptyOrBorder(int row, int col)
-{
-    return (row >= 0 && row < rows && col >= 0 && col < cols && map[row][col] == -1);
-}
-bool GameBoard::canConnect(int row1, int col1, int row2, int col2)
-{
-    // 检查是否是同一个方块
-    if (row1 == row2 && col1 == col2) return false;
-
-    // 检查是否是相同类型的方块
-    if (map[row1][col1] != map[row2][col2] || map[row1][col1] == -1) return false;
-
-    // 使用新的路径查找算法
-    QVector<QPoint> path = findPathBFS(row1, col1, row2, col2);
-    return !path.isEmpty();
-}
-
-bool GameBoard::checkStraightLine(int row1, int col1, int row2, int col2)
-{
-    if (row1 == row2) {
-        int minCol = qMin(col1, col2);
-        int maxCol = qMax(col1, col2);
-        for (int col = minCol + 1; col < maxCol; ++col) {
-            if (!isEmptyOrBorder(row1, col)) return false;
-        }
-    } else if (col1 == col2) {
-        int minRow = qMin(row1, row2);
-        int maxRow = qMax(row1, row2);
-        for (int row = minRow + 1; row < maxRow; ++row) {
-            if (!isEmptyOrBorder(row, col1)) return false;
-        }
-    } else {
-        return false;
-    }
-    return true;
-}
-
 void GameBoard::spawnProp()
 {
-    QVector<PropType> availableProps;
     if (isTwoPlayerMode) {
-        availableProps = {PropType::PlusOneSecond, PropType::Shuffle, PropType::Hint, PropType::Freeze, PropType::Dizzy};
         qDebug() << "Available props for two-player mode:";
     } else {
-        availableProps = {PropType::PlusOneSecond, PropType::Shuffle, PropType::Hint, PropType::Flash};
         qDebug() << "Available props for single-player mode:";
     }
 
     // 输出可用道具
-    for (const auto& prop : availableProps) {
+    for (const auto& prop : board.availableProps()) {
         qDebug() << "  -" << getPropText(prop);
     }
 
-    PropType propType = availableProps[QRandomGenerator::global()->bounded(availableProps.size())];
+    PropType propType = board.randomPropType();
     qDebug() << "Selected prop type:" << getPropText(propType);
 
     // 找到一个空的位置来放置道具
-    int row, col;
-    do {
-        row = QRandomGenerator::global()->bounded(rows);
-        col = QRandomGenerator::global()->bounded(cols);
-    } while (map[row][col] != -1);  // -1 表示空位置
-
-    // 在地图上标记道具位置
-    map[row][col] = -2;  // -2 表示道具
-
-    // 添加道具到道具列表
-    props.push_back({propType, row, col});
+    Board::Point spot;
+    if (!board.spawnProp(propType, &spot)) {
+        qDebug() << "No empty cell for prop:" << getPropText(propType);
+        return;
+    }
+    int row = spot.row;
+    int col = spot.col;
 
     // 更新方块外观
-    updateBlockAppearance(row, col);
+    applyChanges();
 
     // 如果道具生成在玩家位置上，立即激活道具
-    if ((row == player1Row && col == player1Col) || (isTwoPlayerMode && row == player2Row && col == player2Col)) {
+    Board::Point position1 = board.playerPosition(1);
+    Board::Point position2 = board.playerPosition(2);
+    if ((row == position1.row && col == position1.col) || (isTwoPlayerMode && row == position2.row && col == position2.col)) {
         activateProp(propType);
         // 移除已激活的道具
-        props.removeIf([row, col](const Prop& prop) { return prop.row == row && prop.col == col; });
-        map[row][col] = -1;  // 将位置标记为空
-        updateBlockAppearance(row, col);
+        board.takeProp(row, col);
+        applyChanges();
     }
 
     // 调试输出
@@ -1503,32 +1338,14 @@ void GameBoard::activateProp(PropType type)
 
 void GameBoard::plusOneSecond()
 {
-    remainingTime += 30;
+    board.addTime(30);
     updateTimer();
 }
 
 void GameBoard::shuffleBlocks()
 {
-    QVector<int> blockTypes;
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            if (map[i][j] >= 0) {
-                blockTypes.push_back(map[i][j]);
-            }
-        }
-    }
-
-    std::random_shuffle(blockTypes.begin(), blockTypes.end());
-
-    int index = 0;
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            if (map[i][j] >= 0) {
-                map[i][j] = blockTypes[index++];
-                updateBlockAppearance(i, j);
-            }
-        }
-    }
+    board.shuffleBlocks(Board::ShuffleMode::Solvable);
+    applyChanges();
 }
 
 void GameBoard::startHint()
@@ -1538,38 +1355,25 @@ void GameBoard::startHint()
     }
 
     // 查找可以连接的方块对
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            if (map[i][j] >= 0) {
-                for (int m = 0; m < rows; ++m) {
-                    for (int n = 0; n < cols; ++n) {
-                        if ((i != m || j != n) && map[i][j] == map[m][n]) {
-                            QVector<QPoint> path = findPath(i, j, m, n);
-                            qDebug() << "path found, " << i << "," << j << " to " << m <<","<<n;
-
-                            if (!path.isEmpty()) {
-                                hintBlocks.push_back({i, j});
-                                hintBlocks.push_back({m, n});
-                                highlightHintBlocks();
-
-                                // 设置定时器，5秒后停止提示
-                                if (hintTimer) {
-                                    hintTimer->stop();
-                                    disconnect(hintTimer, &QTimer::timeout, this, &GameBoard::stopHint);
-                                    delete hintTimer;
-                                }
-
-                                hintTimer = new QTimer(this);
-                                connect(hintTimer, &QTimer::timeout, this, &GameBoard::stopHint);
-                                hintTimer->setSingleShot(true);
-                                hintTimer->start(5000);
-                                return;
-                            }
-                        }
-                    }
-                }
-            }
+    Board::Point first, second;
+    if (board.findHintPair(&first, &second)) {
+        qDebug() << "path found, " << first.row << "," << first.col << " to " << second.row << "," << second.col;
+        hintBlocks.push_back({first.row, first.col});
+        hintBlocks.push_back({second.row, second.col});
+        highlightHintBlocks();
+
+        // 设置定时器，5秒后停止提示
+        if (hintTimer) {
+            hintTimer->stop();
+            disconnect(hintTimer, &QTimer::timeout, this, &GameBoard::stopHint);
+            delete hintTimer;
         }
+
+        hintTimer = new QTimer(this);
+        connect(hintTimer, &QTimer::timeout, this, &GameBoard::stopHint);
+        hintTimer->setSingleShot(true);
+        hintTimer->start(5000);
+        return;
     }
 
     // 如果没有找到可连接的方块对，显示提示信息
@@ -1595,26 +1399,16 @@ void GameBoard::highlightHintBlocks()
 
     clearHintHighlight();
 
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            if (map[i][j] >= 0) {
-                for (int x = i; x < rows; ++x) {
-                    for (int y = (x == i ? j + 1 : 0); y < cols; ++y) {
-                        if (map[x][y] == map[i][j] && canConnect(i, j, x, y)) {
-                            hintBlocks = {{i, j}, {x, y}};
-
-                            qDebug() << "highlightHintBlocks " << i << "," << j << " to " << x <<"," <<y;
+    Board::Point first, second;
+    if (!board.findHintPair(&first, &second)) {
+        return;
+    }
+    hintBlocks = {{first.row, first.col}, {second.row, second.col}};
 
-                            buttons[i][j]->setStyleSheet("background-color: lightgreen; border: 2px solid black;");
-                            buttons[x][y]->setStyleSheet("background-color: lightgreen; border: 2px solid black;");
+    qDebug() << "highlightHintBlocks " << first.row << "," << first.col << " to " << second.row << "," << second.col;
 
-                            return;
-                        }
-                    }
-                }
-            }
-        }
-    }
+    buttons[first.row][first.col]->setStyleSheet("background-color: lightgreen; border: 2px solid black;");
+    buttons[second.row][second.col]->setStyleSheet("background-color: lightgreen; border: 2px solid black;");
 }
 
 void GameBoard::clearHintHighlight()
@@ -1654,18 +1448,8 @@ void GameBoard::mousePressEvent(QMouseEvent *event)
         int row = event->pos().y() / CELL_SIZE;
         qDebug() << "Mouse click position - row:" << row << "col:" << col;
 
-        if (row >= 0 && row < rows && col >= 0 && col < cols) {
-            qDebug() << "Position is within bounds.";
-            if (canReachPosition(player1Row, player1Col, row, col)) {
-                qDebug() << "Position is reachable.";
-                movePlayerToNearestEmptyCell(1, row, col);
-                if (map[row][col] >= 0) {
-                    qDebug() << "Activating block at row:" << row << "col:" << col;
-                    activateBlock(1, row, col);
-                }
-            } else {
-                qDebug() << "Position is not reachable.";
-            }
+        if (board.contains(row, col)) {
+            flashPlayerTo(1, row, col);
         } else {
             qDebug() << "Position is out of bounds.";
         }
@@ -1678,98 +1462,42 @@ void GameBoard::mousePressEvent(QMouseEvent *event)
     event->accept();
 }
 
-bool GameBoard::canReachPosition(int startRow, int startCol, int endRow, int endCol)
+void GameBoard::flashPlayerTo(int player, int row, int col)
 {
-    qDebug() << "Checking if position is reachable from (" << startRow << "," << startCol << ") to (" << endRow << "," << endCol << ")";
-
-    QQueue<QPair<int, int>> queue;
-    QVector<QVector<bool>> visited(rows, QVector<bool>(cols, false));
-
-    queue.enqueue({startRow, startCol});
-    visited[startRow][startCol] = true;
-
-    while (!queue.isEmpty()) {
-        QPair<int, int> current = queue.dequeue();
-        int r = current.first;
-        int c = current.second;
-
-        if (r == endRow && c == endCol) {
-            qDebug() << "Position is reachable.";
-            return true;
-        }
-
-        static const int dr[] = {-1, 1, 0, 0};
-        static const int dc[] = {0, 0, -1, 1};
-
-        for (int i = 0; i < 4; ++i) {
-            int newRow = r + dr[i];
-            int newCol = c + dc[i];
-
-            if (newRow >= 0 && newRow < rows && newCol >= 0 && newCol < cols &&
-                !visited[newRow][newCol] && isEmptyOrBorder(newRow, newCol)) {
-                queue.enqueue({newRow, newCol});
-                visited[newRow][newCol] = true;
-            }
-        }
+    // 点击空地时直接移动过去；点击方块时移动到方块旁边，并激活该方块
+    Board::Point position = board.playerPosition(player);
+    Board::Point destination;
+    if (!board.findFlashDestination(position.row, position.col, row, col, &destination)) {
+        return;
     }
 
-    qDebug() << "Position is not reachable.";
-    return false;
-}
-
-void GameBoard::movePlayerToNearestEmptyCell(int player, int targetRow, int targetCol)
-{
-    qDebug() << "Moving player" << player << "to nearest empty cell around (" << targetRow << "," << targetCol << ")";
-
-    static const int dr[] = {0, -1, 1, 0, 0};
-    static const int dc[] = {0, 0, 0, -1, 1};
-
-    for (int i = 0; i < 5; ++i) {
-        int newRow = targetRow + dr[i];
-        int newCol = targetCol + dc[i];
-
-        if (newRow >= 0 && newRow < rows && newCol >= 0 && newCol < cols &&
-            isEmptyOrBorder(newRow, newCol)) {
-            if (player == 1) {
-                player1Row = newRow;
-                player1Col = newCol;
-            } else {
-                player2Row = newRow;
-                player2Col = newCol;
-            }
-            updatePlayersPosition();
-            qDebug() << "Player" << player << "moved to (" << newRow << "," << newCol << ")";
-            return;
-        }
+    board.setPlayerPosition(player, destination.row, destination.col);
+    if (board.cell(row, col) >= 0) {
+        activateBlock(player, row, col);
     }
-
-    qDebug() << "No empty cell found around (" << targetRow << "," << targetCol << ")";
+    applyChanges();
 }
 
 void GameBoard::updateBlockAppearance(int row, int col)
 {
-    if (row < 0 || row >= rows || col < 0 || col >= cols || !buttons[row][col]) {
+    if (!board.contains(row, col) || !buttons[row][col]) {
         return;
     }
 
     QPushButton *button = buttons[row][col];
-    int blockType = map[row][col];
+    int blockType = board.cell(row, col);
 
-    if (blockType == -1) {
+    if (blockType == Board::EMPTY) {
         // 空白方块
         button->setStyleSheet("background-color: lightgray; border: 1px solid gray;");
         button->setIcon(QIcon());
         button->setText("");
-    } else if (blockType == -2) {
+    } else if (blockType == Board::PROP) {
         // 道具
-        for (const auto &prop : props) {
-            if (prop.row == row && prop.col == col) {
-                button->setStyleSheet(getPropStyleSheet(prop.type));
-                button->setText(getPropText(prop.type));
-                button->setIcon(QIcon());
-                break;
-            }
-        }
+        PropType propType = board.propAt(row, col);
+        button->setStyleSheet(getPropStyleSheet(propType));
+        button->setText(getPropText(propType));
+        button->setIcon(QIcon());
     } else if (blockType >= 0 && blockType < blockImages.size()) {
         // 普通方块
         button->setStyleSheet("");
@@ -1782,21 +1510,26 @@ void GameBoard::updateBlockAppearance(int row, int col)
 
 void GameBoard::updatePlayerAppearance(int row, int col)
 {
-    if (row < 0 || row >= rows || col < 0 || col >= cols || !buttons[row][col]) {
+    if (!board.contains(row, col) || !buttons[row][col]) {
         qDebug() << "Invalid position or button in updatePlayerAppearance:" << row << "," << col;
         return;
     }
 
     QPushButton *button = buttons[row][col];
-    if (row == player1Row && col == player1Col) {
+    Board::Point position1 = board.playerPosition(1);
+    Board::Point position2 = board.playerPosition(2);
+    if (row == position1.row && col == position1.col) {
         button->setStyleSheet("background-color: rgba(255, 0, 0, 128); border: 2px solid darkred;");
     }
-    else if (isTwoPlayerMode && row == player2Row && col == player2Col) {
+    else if (isTwoPlayerMode && row == position2.row && col == position2.col) {
         button->setStyleSheet("background-color: rgba(0, 0, 255, 128); border: 2px solid darkblue;");
-        player2 = new QGraphicsEllipseItem(0, 0, PLAYER_SIZE, PLAYER_SIZE);
-        player2->setBrush(QBrush(Qt::blue));
-        player2->setPen(QPen(Qt::black));
-        scene->addItem(player2);
+        // 单人模式下读取双人存档时还没有玩家2的图标
+        if (!player2) {
+            player2 = new QGraphicsEllipseItem(0, 0, PLAYER_SIZE, PLAYER_SIZE);
+            player2->setBrush(QBrush(Qt::blue));
+            player2->setPen(QPen(Qt::black));
+            scene->addItem(player2);
+        }
     }
 }
 
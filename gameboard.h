@@ -15,24 +15,17 @@
 #include <QQueue>
 #include <QGraphicsProxyWidget>
 #include <QGraphicsEllipseItem>
+#include "board.h"
 
 class GameBoard : public QWidget
 {
     Q_OBJECT
 
 public:
-    explicit GameBoard(QWidget *parent = nullptr, bool isTwoPlayerMode = false);
-    enum class PropType {
-        None,
-        PlusOneSecond,
-        Shuffle,
-        Hint,
-        Flash,  // 仅在单人模式中使用
-        Freeze, // 仅在双人模式中使用
-        Dizzy   // 仅在双人模式中使用
-    };
+    // fromSave 为 true 时不取预先生成的地图，调用方随后用 loadGame 读入存档
+    explicit GameBoard(QWidget *parent = nullptr, bool isTwoPlayerMode = false, bool fromSave = false);
+    using PropType = Board::PropType;
     void setupGame();
-    void runTests(); // 新增的测试方法
 
 protected:
     void keyPressEvent(QKeyEvent *event) override;
@@ -53,57 +46,43 @@ public slots:
 private:
     static const int MAX_COLS = 15;
     static const int MAX_ROWS = 15;
-    bool checkStraightLine(int row1, int col1, int row2, int col2);
-    void generateMap();
     void drawMap(QGridLayout *layout);
     void movePlayer(int player, int dx, int dy);
     void activateBlock(int player, int row, int col);
     void checkAndRemoveBlocks();
     void loadImages();
-    bool isGameFinished();
     //void updatePlayersPosition();
     void updatePlayersPosition();
-    bool isMapSolvable();
-    int countBlockType(int type);
     bool isTwoPlayerMode;
     int currentPlayer;
     QLabel *playerTurnLabel;
     void switchPlayer();
     void updatePlayerTurnLabel();
-    int rows;
-    int cols;
-    QVector<QVector<int>> map;
+    Board board;  // 地图、道具、分数和剩余时间都由规则引擎维护
     QVector<QVector<QPushButton*>> buttons;
     QVector<QPixmap> blockImages;
     QPair<int, int> lastActivatedBlock;
     bool isBlockActivated;
     static const int CELL_SIZE = 50;  // 每个格子的大小
     static const int PLAYER_SIZE = 30;  // 玩家图标的大小
-    static const int GRID_SIZE = 14;  // 网格的大小（行数和列数）
+    static const int DEADLOCK_CHECK_MS = 15;  // 每次消除后求解器确认死局的时间预算（毫秒）
     QLabel *player1ScoreLabel;
     QLabel *player2ScoreLabel;
-    int player1Score;
-    int player2Score;
     void updateScoreLabels();
+    void updateTimerLabel();
+    void applyChanges();  // 只重绘 board 记录下来的变化
     void addScore(int player, int points);
     void checkGameEnd();
     QGraphicsEllipseItem *player1;
     QGraphicsEllipseItem *player2;
-    int player1Row;
-    int player1Col;
-    int player2Row;
-    int player2Col;
     QPair<int, int> lastActivatedBlock1;
     QPair<int, int> lastActivatedBlock2;
     bool isBlockActivated1;
     bool isBlockActivated2;
     QTimer *gameTimer;
     QLabel *timerLabel;
-    int remainingTime;
-    static const int GAME_DURATION = 300; // 游戏时长（秒）
     void startGame();
     void endGame(const QString &reason);
-    bool hasMatchingPairs();
     QPushButton *pauseButton;
     QPushButton *saveButton;
     QPushButton *loadButton;
@@ -113,30 +92,14 @@ private:
     void deserializeGame(QDataStream &in);
     QGraphicsScene *scene;
     QGraphicsView *view;
-    void drawConnectionLine(int row1, int col1, int row2, int col2);
+    void drawConnectionLine(const std::vector<Board::Point> &path);
     void clearConnectionLines();
-    QVector<QPoint> findPath(int row1, int col1, int row2, int col2);
-    bool canConnect(int row1, int col1, int row2, int col2);
-    bool isEmptyOrBorder(int row, int col);
-    bool allBlocksCleared();
-    QVector<QPoint> findPathBFS(int row1, int col1, int row2, int col2);
-    struct PathNode {
-        int row, col;
-        QVector<QPoint> path;
-        int turns;
-    };
     static const int Z_BACKGROUND = 0;
     static const int Z_NORMAL_BLOCK = 1;
     static const int Z_BORDER_BLOCK = 2;
     static const int Z_PLAYER = 98;
     static const int Z_CONNECTION_LINE = 99;
-    struct Prop {
-        PropType type;
-        int row;
-        int col;
-    };
     QString getPropText(PropType type);
-    QVector<Prop> props;
     QTimer *propSpawnTimer;
     QTimer *hintTimer;
     QTimer *flashTimer;
@@ -154,8 +117,7 @@ private:
     void clearCurrentMap();
     void highlightHintBlocks();
     void clearHintHighlight();
-    bool canReachPosition(int startRow, int startCol, int endRow, int endCol);
-    void movePlayerToNearestEmptyCell(int player, int targetRow, int targetCol);
+    void flashPlayerTo(int player, int row, int col);
     void updateBlockAppearance(int row, int col);
     QString getPropStyleSheet(PropType type);
     QTimer *freezeTimer;
@@ -176,6 +138,7 @@ private:
     void setupUI();
     void updateUI();
     void loadPlayersPosition();
+    void updatePlayerCells();  // 重绘玩家所在的格子
     void loadTimer();
     void resizeMap(int newRows, int newCols);
     void initializeGameBoard();
@@ -1,4 +1,5 @@
 #include "startmenu.h"
+#include "boardpool.h"
 #include <QApplication>
 #include <QLocale>
 #include <QTranslator>
@@ -16,6 +17,11 @@ int main(int argc, char *argv[])
             break;
         }
     }
+    // 菜单显示的同时在后台为两种模式各准备几张地图，退出前停掉后台线程
+    BoardPool::instance().prepare(false);
+    BoardPool::instance().prepare(true);
+    QObject::connect(&a, &QCoreApplication::aboutToQuit, [] { BoardPool::instance().stop(); });
+
     StartMenu startMenu;
     startMenu.show();
     return a.exec();
@@ -0,0 +1,540 @@
+// 寻路差分测试：随机生成棋盘，把引擎的各条寻路路径与在 (格子, 方向) 上搜索的参考实现对比
+// 发现不一致时把棋盘缩减到仍能复现的最小局面并打印出来
+// 用法：pathfuzz [--queries N] [--seed S]
+#include "board.h"
+#include "fixedboard.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// 一个测试局面：地图内容、连接规则和一次查询的两个端点
+struct Case {
+    int rows = 0;
+    int cols = 0;
+    std::vector<int> cells;  // Board::cell 的取值
+    Board::LinkRule rule;
+    int row1 = 0, col1 = 0, row2 = 0, col2 = 0;
+
+    int at(int row, int col) const { return cells[row * cols + col]; }
+    int &at(int row, int col) { return cells[row * cols + col]; }
+};
+
+// ---------------- 参考实现：直接在二维数组上按 (格子, 方向) 搜索最优路线 ----------------
+
+bool passable(const Case &c, bool outside, int row, int col)
+{
+    if (row < 0 || row >= c.rows || col < 0 || col >= c.cols) {
+        return outside && row >= -1 && row <= c.rows && col >= -1 && col <= c.cols;
+    }
+    return c.at(row, col) == Board::EMPTY;
+}
+
+// 两点之间（不含两端）都可以通过
+bool segmentClear(const Case &c, bool outside, int row1, int col1, int row2, int col2)
+{
+    int dr = (row2 > row1) - (row2 < row1);
+    int dc = (col2 > col1) - (col2 < col1);
+    for (int r = row1 + dr, k = col1 + dc; r != row2 || k != col2; r += dr, k += dc) {
+        if (!passable(c, outside, r, k)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 把一串点合并成去掉零长度段和共线中间点的折线，返回转折次数和长度
+void measure(std::vector<Board::Point> points, int *turns, int *length)
+{
+    std::vector<Board::Point> path;
+    for (const Board::Point &p : points) {
+        if (path.empty() || path.back().row != p.row || path.back().col != p.col) {
+            path.push_back(p);
+        }
+    }
+    *length = 0;
+    *turns = 0;
+    int lastDr = 0, lastDc = 0;
+    for (size_t i = 1; i < path.size(); ++i) {
+        int dr = (path[i].row > path[i - 1].row) - (path[i].row < path[i - 1].row);
+        int dc = (path[i].col > path[i - 1].col) - (path[i].col < path[i - 1].col);
+        *length += std::abs(path[i].row - path[i - 1].row) + std::abs(path[i].col - path[i - 1].col);
+        if (i > 1 && (dr != lastDr || dc != lastDc)) {
+            ++*turns;
+        }
+        lastDr = dr;
+        lastDc = dc;
+    }
+}
+
+// 在 (格子, 前进方向) 上做 Dijkstra：限制转折时按 (转折, 长度) 取最小，不限转折（maxTurns < 0）时按 (长度, 转折)
+bool referenceLink(const Case &c, bool outside, int maxTurns, int row1, int col1, int row2, int col2,
+                   int *bestTurns, int *bestLength)
+{
+    if (row1 == row2 && col1 == col2) {
+        return false;
+    }
+    static const int dr[4] = {0, 0, -1, 1};
+    static const int dc[4] = {-1, 1, 0, 0};
+    int low = outside ? -1 : 0;
+    int cols = c.cols + (outside ? 2 : 0);
+    int rows = c.rows + (outside ? 2 : 0);
+    using Cost = std::pair<int, int>;
+    auto costOf = [maxTurns](int turns, int length) {
+        return maxTurns < 0 ? Cost(length, turns) : Cost(turns, length);
+    };
+    using State = std::tuple<Cost, int, int, int>;  // 代价、行、列、方向
+    std::priority_queue<State, std::vector<State>, std::greater<State>> queue;
+    std::vector<Cost> best(rows * cols * 4, Cost(INT_MAX, INT_MAX));
+    bool found = false;
+    Cost bestCost;
+
+    auto relax = [&](int row, int col, int dir, int turns, int length) {
+        if (maxTurns >= 0 && turns > maxTurns) {
+            return;
+        }
+        Cost cost = costOf(turns, length);
+        if (row == row2 && col == col2) {
+            if (!found || cost < bestCost) {
+                found = true;
+                bestCost = cost;
+                *bestTurns = turns;
+                *bestLength = length;
+            }
+            return;
+        }
+        if (!passable(c, outside, row, col)) {
+            return;
+        }
+        int id = ((row - low) * cols + (col - low)) * 4 + dir;
+        if (cost < best[id]) {
+            best[id] = cost;
+            queue.push(State(cost, row, col, dir));
+        }
+    };
+
+    for (int dir = 0; dir < 4; ++dir) {
+        relax(row1 + dr[dir], col1 + dc[dir], dir, 0, 1);
+    }
+    while (!queue.empty()) {
+        Cost cost;
+        int row, col, dir;
+        std::tie(cost, row, col, dir) = queue.top();
+        queue.pop();
+        // 每走一步代价都变大，出队的代价不小于已找到的终点时不会再有更好的路线
+        if (found && !(cost < bestCost)) {
+            break;
+        }
+        if (cost != best[((row - low) * cols + (col - low)) * 4 + dir]) {
+            continue;
+        }
+        int turns = maxTurns < 0 ? cost.second : cost.first;
+        int length = maxTurns < 0 ? cost.first : cost.second;
+        for (int next = 0; next < 4; ++next) {
+            if (next != (dir ^ 1)) {  // 掉头不会出现在最优路线上
+                relax(row + dr[next], col + dc[next], next, turns + (next != dir), length + 1);
+            }
+        }
+    }
+    return found;
+}
+
+bool referenceConnect(const Case &c, int row1, int col1, int row2, int col2, int *turns, int *length)
+{
+    int value = c.at(row1, col1);
+    if (value < 0 || value != c.at(row2, col2)) {
+        return false;
+    }
+    return referenceLink(c, c.rule.allowOutside, c.rule.maxTurns, row1, col1, row2, col2, turns, length);
+}
+
+// 检查引擎给出的路线：相邻两点同行或同列，中间格子和拐点都可以通过
+bool routeValid(const Case &c, bool outside, const std::vector<Board::Point> &route, int row1, int col1, int row2, int col2)
+{
+    if (route.size() < 2 || route.front().row != row1 || route.front().col != col1 ||
+        route.back().row != row2 || route.back().col != col2) {
+        return false;
+    }
+    for (size_t i = 1; i < route.size(); ++i) {
+        const Board::Point &a = route[i - 1];
+        const Board::Point &b = route[i];
+        if ((a.row != b.row) == (a.col != b.col)) {
+            return false;
+        }
+        if (!segmentClear(c, outside, a.row, a.col, b.row, b.col)) {
+            return false;
+        }
+        if (i + 1 < route.size() && !passable(c, outside, b.row, b.col)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------- 被测引擎 ----------------
+
+Board makeBoard(const Case &c)
+{
+    Board board;
+    board.resize(c.rows, c.cols);
+    for (int r = 0; r < c.rows; ++r) {
+        for (int k = 0; k < c.cols; ++k) {
+            if (c.at(r, k) == Board::PROP) {
+                board.addProp(Board::PropType::Hint, r, k);
+            } else if (c.at(r, k) != Board::EMPTY) {
+                board.setCell(r, k, c.at(r, k));
+            }
+        }
+    }
+    board.setLinkRule(c.rule);
+    return board;
+}
+
+std::string describeRoute(const std::vector<Board::Point> &route)
+{
+    std::string text;
+    for (const Board::Point &p : route) {
+        text += "(" + std::to_string(p.row) + "," + std::to_string(p.col) + ")";
+    }
+    return text.empty() ? "none" : text;
+}
+
+// 同一张地图在每种固定规则下各建一个 Board：各个转折上限，分别限制在地图内和允许绕到地图外
+// 大棋盘上每次查询跑十遍参考搜索太慢，只在不超过 20x20 的棋盘上做；大棋盘由各局随机的规则覆盖
+std::vector<Board> makeRuleBoards(const Case &c)
+{
+    static const int turnLimits[] = {0, 1, 2, Board::MAX_TURNS, Board::UNLIMITED_TURNS};
+    std::vector<Board> boards;
+    if (c.rows * c.cols > 400) {
+        return boards;
+    }
+    for (bool outside : {false, true}) {
+        for (int maxTurns : turnLimits) {
+            Case ruled = c;
+            ruled.rule.maxTurns = maxTurns;
+            ruled.rule.allowOutside = outside;
+            boards.push_back(makeBoard(ruled));
+        }
+    }
+    return boards;
+}
+
+// 对局面中的一次查询比较所有引擎，有不一致时返回 true 并写入说明；board 和 ruleBoards 必须与 c 的地图一致
+bool queryDisagrees(const Board &board, const std::vector<Board> &ruleBoards, const Case &c, std::string *detail)
+{
+    int r1 = c.row1, c1 = c.col1, r2 = c.row2, c2 = c.col2;
+
+    // 按当前规则连接：canConnect、findPath 的路线合法且 (转折, 长度) 最优
+    int turns = 0, length = 0;
+    bool expected = referenceConnect(c, r1, c1, r2, c2, &turns, &length);
+    if (board.canConnect(r1, c1, r2, c2) != expected) {
+        *detail = "canConnect returned " + std::string(expected ? "false" : "true");
+        return true;
+    }
+    std::vector<Board::Point> path = board.findPath(r1, c1, r2, c2);
+    if (path.empty() != !expected) {
+        *detail = "findPath returned " + describeRoute(path);
+        return true;
+    }
+    if (expected) {
+        int gotTurns, gotLength;
+        measure(path, &gotTurns, &gotLength);
+        if (!routeValid(c, c.rule.allowOutside, path, r1, c1, r2, c2) || gotTurns != turns || gotLength != length) {
+            *detail = "findPath returned " + describeRoute(path) + ", expected " + std::to_string(turns) +
+                      " turns and length " + std::to_string(length);
+            return true;
+        }
+    }
+
+    // 不论本局的规则是什么，同一次查询在每种固定规则下都用 connect 检查一遍
+    for (const Board &ruled : ruleBoards) {
+        const Board::LinkRule &rule = ruled.linkRule();
+        Case ruledCase = c;
+        ruledCase.rule = rule;
+        bool want = referenceConnect(ruledCase, r1, c1, r2, c2, &turns, &length);
+        Board::Route route;
+        bool got = ruled.connect(r1, c1, r2, c2, &route);
+        std::string name = "connect(maxTurns " + std::to_string(rule.maxTurns) +
+                           (rule.allowOutside ? ", outside)" : ")");
+        if (got != want || route.empty() == got) {
+            *detail = name + " returned " + describeRoute(route);
+            return true;
+        }
+        int gotTurns, gotLength;
+        measure(route, &gotTurns, &gotLength);
+        if (want && (!routeValid(c, rule.allowOutside, route, r1, c1, r2, c2) || gotTurns != turns || gotLength != length)) {
+            *detail = name + " returned " + describeRoute(route) + ", expected " + std::to_string(turns) +
+                      " turns and length " + std::to_string(length);
+            return true;
+        }
+    }
+
+    // 不检查方块类型的两折内核（只对两个被占用的格子有意义）
+    if (c.at(r1, c1) != Board::EMPTY && c.at(r2, c2) != Board::EMPTY) {
+        bool link = referenceLink(c, false, 2, r1, c1, r2, c2, &turns, &length);
+        if (board.bitBoard().canLink(r1, c1, r2, c2) != link) {
+            *detail = "BitBoard::canLink returned " + std::string(link ? "false" : "true");
+            return true;
+        }
+        if (FixedKernels::canLink(board, r1, c1, r2, c2) != link) {
+            *detail = "FixedKernels::canLink returned " + std::string(link ? "false" : "true");
+            return true;
+        }
+    }
+    return false;
+}
+
+bool freshQueryDisagrees(const Case &c, std::string *detail)
+{
+    return queryDisagrees(makeBoard(c), makeRuleBoards(c), c, detail);
+}
+
+int referencePairCount(const Case &c)
+{
+    int count = 0;
+    int turns, length;
+    for (int a = 0; a < c.rows * c.cols; ++a) {
+        for (int b = a + 1; b < c.rows * c.cols; ++b) {
+            if (referenceConnect(c, a / c.cols, a % c.cols, b / c.cols, b % c.cols, &turns, &length)) {
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+// 新建棋盘后可以消除的对数（批量内核和对的索引）与参考实现比较
+bool pairCountDisagrees(const Case &c, std::string *detail)
+{
+    Board board = makeBoard(c);
+    int expected = referencePairCount(c);
+    int got = board.countLinkablePairs();
+    if (got != expected) {
+        *detail = "countLinkablePairs returned " + std::to_string(got) + ", expected " + std::to_string(expected);
+        return true;
+    }
+    return false;
+}
+
+// ---------------- 生成与缩减 ----------------
+
+Case randomCase(std::mt19937_64 &rng)
+{
+    static const int squareSizes[] = {Board::GRID_SIZE, 20, 30, 40};  // 默认尺寸走特化内核，其余走通用实现
+    Case c;
+    int shape = rng() % 10;
+    if (shape < 6) {
+        c.rows = 1 + rng() % 10;
+        c.cols = 1 + rng() % 10;
+    } else if (shape < 9) {
+        c.rows = c.cols = squareSizes[rng() % 4];
+    } else {
+        c.rows = 1 + rng() % Board::MAX_SIZE;
+        c.cols = 1 + rng() % Board::MAX_SIZE;
+    }
+
+    int density = rng() % 101;
+    int types = 1 + rng() % (rng() % 4 == 0 ? Board::MAX_BLOCK_TYPES : Board::BLOCK_TYPES);
+    c.cells.assign(c.rows * c.cols, Board::EMPTY);
+    for (int &cell : c.cells) {
+        if (static_cast<int>(rng() % 100) < density) {
+            cell = rng() % 20 == 0 ? Board::PROP : static_cast<int>(rng() % types);
+        }
+    }
+
+    static const int turnChoices[] = {2, 2, 2, 0, 1, 3, Board::UNLIMITED_TURNS};
+    c.rule.maxTurns = turnChoices[rng() % 7];
+    c.rule.allowOutside = rng() % 3 == 0;
+    return c;
+}
+
+void randomQuery(Case &c, std::mt19937_64 &rng)
+{
+    // 多数查询取同类方块，使能连接与不能连接的情况都足够多
+    c.row1 = rng() % c.rows;
+    c.col1 = rng() % c.cols;
+    c.row2 = rng() % c.rows;
+    c.col2 = rng() % c.cols;
+    int value = c.at(c.row1, c.col1);
+    if (value >= 0 && rng() % 4 != 0) {
+        for (int attempt = 0; attempt < 8 && c.at(c.row2, c.col2) != value; ++attempt) {
+            c.row2 = rng() % c.rows;
+            c.col2 = rng() % c.cols;
+        }
+    }
+}
+
+// 删掉第 index 行（或列）后的局面，查询端点一起平移；端点在被删的那一行时返回 false
+bool removeLine(const Case &c, bool row, int index, Case *result)
+{
+    if (row ? (c.rows == 1 || c.row1 == index || c.row2 == index)
+            : (c.cols == 1 || c.col1 == index || c.col2 == index)) {
+        return false;
+    }
+    *result = c;
+    result->rows = c.rows - (row ? 1 : 0);
+    result->cols = c.cols - (row ? 0 : 1);
+    result->cells.clear();
+    for (int r = 0; r < c.rows; ++r) {
+        for (int k = 0; k < c.cols; ++k) {
+            if ((row && r != index) || (!row && k != index)) {
+                result->cells.push_back(c.at(r, k));
+            }
+        }
+    }
+    if (row) {
+        result->row1 -= c.row1 > index;
+        result->row2 -= c.row2 > index;
+    } else {
+        result->col1 -= c.col1 > index;
+        result->col2 -= c.col2 > index;
+    }
+    return true;
+}
+
+// 反复尝试删掉整行整列、清空单个格子，只要仍然不一致就保留修改
+Case minimise(Case c, const std::function<bool(const Case &, std::string *)> &disagrees)
+{
+    std::string detail;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int pass = 0; pass < 2; ++pass) {
+            bool row = pass == 0;
+            for (int index = (row ? c.rows : c.cols) - 1; index >= 0; --index) {
+                Case smaller;
+                if (removeLine(c, row, index, &smaller) && disagrees(smaller, &detail)) {
+                    c = smaller;
+                    changed = true;
+                }
+            }
+        }
+        for (int r = 0; r < c.rows; ++r) {
+            for (int k = 0; k < c.cols; ++k) {
+                bool endpoint = (r == c.row1 && k == c.col1) || (r == c.row2 && k == c.col2);
+                if (endpoint || c.at(r, k) == Board::EMPTY) {
+                    continue;
+                }
+                Case simpler = c;
+                simpler.at(r, k) = Board::EMPTY;
+                if (disagrees(simpler, &detail)) {
+                    c = simpler;
+                    changed = true;
+                }
+            }
+        }
+    }
+    return c;
+}
+
+void printCase(const Case &c, bool withQuery)
+{
+    std::printf("board %dx%d, rule: maxTurns %d, allowOutside %d\n", c.rows, c.cols, c.rule.maxTurns,
+                c.rule.allowOutside ? 1 : 0);
+    if (withQuery) {
+        std::printf("query (%d,%d) -> (%d,%d)\n", c.row1, c.col1, c.row2, c.col2);
+    }
+    // . 空地，* 道具，A~P 方块类型
+    for (int r = 0; r < c.rows; ++r) {
+        std::string line;
+        for (int k = 0; k < c.cols; ++k) {
+            int value = c.at(r, k);
+            line += value == Board::EMPTY ? '.' : value == Board::PROP ? '*' : static_cast<char>('A' + value);
+        }
+        std::printf("  %s\n", line.c_str());
+    }
+}
+
+int report(const Case &failing, const std::function<bool(const Case &, std::string *)> &disagrees, bool withQuery)
+{
+    Case small = minimise(failing, disagrees);
+    std::string detail;
+    disagrees(small, &detail);
+    std::printf("MISMATCH: %s\n", detail.c_str());
+    printCase(small, withQuery);
+    return 1;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    long long queries = 200000;
+    unsigned long long seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--queries") == 0 && i + 1 < argc) {
+            queries = std::atoll(argv[++i]);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            std::fprintf(stderr, "usage: %s [--queries N] [--seed S]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::mt19937_64 rng(seed);
+    long long done = 0;
+    long long linked = 0;
+    int boards = 0;
+    while (done < queries) {
+        Case c = randomCase(rng);
+        Board board = makeBoard(c);
+        std::vector<Board> ruleBoards = makeRuleBoards(c);
+        ++boards;
+
+        // 同一张棋盘上的多次查询复用一个 Board；出现不一致时再用单独的局面复现和缩减
+        int perBoard = 50 + c.rows * c.cols / 4;
+        for (int q = 0; q < perBoard && done < queries; ++q, ++done) {
+            randomQuery(c, rng);
+            std::string detail;
+            int turns, length;
+            linked += referenceConnect(c, c.row1, c.col1, c.row2, c.col2, &turns, &length);
+            if (queryDisagrees(board, ruleBoards, c, &detail)) {
+                if (freshQueryDisagrees(c, &detail)) {
+                    return report(c, freshQueryDisagrees, true);
+                }
+                // 只在复用的棋盘上出现，说明问题出在查询之间残留的状态（例如缓存）
+                std::printf("MISMATCH: %s (only on a board reused across queries)\n", detail.c_str());
+                printCase(c, true);
+                return 1;
+            }
+        }
+
+        // 小棋盘上再按提示连续消除几对，检查增量维护的对的索引
+        if (c.rows * c.cols <= 120) {
+            for (int step = 0; step < 6; ++step) {
+                int expected = referencePairCount(c);
+                if (board.countLinkablePairs() != expected) {
+                    std::string detail;
+                    if (pairCountDisagrees(c, &detail)) {
+                        return report(c, pairCountDisagrees, false);
+                    }
+                    std::printf("MISMATCH: pair index out of date after removals (%d pairs, expected %d)\n",
+                                board.countLinkablePairs(), expected);
+                    printCase(c, false);
+                    return 1;
+                }
+                Board::Point first, second;
+                if (!board.findHintPair(&first, &second) ||
+                    !board.matchPair(1, first.row, first.col, second.row, second.col)) {
+                    break;
+                }
+                c.at(first.row, first.col) = Board::EMPTY;
+                c.at(second.row, second.col) = Board::EMPTY;
+            }
+        }
+    }
+
+    std::printf("pathfuzz: %lld queries on %d boards (%lld connectable), seed %llu: ok\n", done, boards, linked, seed);
+    return 0;
+}